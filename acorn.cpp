@@ -54,6 +54,27 @@ void queryPackage(const string &name)
     return;
 }
 
+// The number of jobs given after Flag, which must be a positive
+// whole number
+unsigned int getJobCount(const string &Flag, const string &What)
+{
+    bool isValid = !What.empty() && What.size() <= 6;
+    for (char c : What)
+    {
+        if (c < '0' || c > '9')
+        {
+            isValid = false;
+        }
+    }
+
+    if (!isValid || stoi(What) == 0)
+    {
+        throw runtime_error(Flag + " must be followed by a positive number of jobs, not '" + What + "'");
+    }
+
+    return stoi(What);
+}
+
 int main(const int argc, const char *argv[])
 {
     auto start = chrono::high_resolution_clock::now(), end = start, compStart = start, compEnd = start;
@@ -183,6 +204,24 @@ int main(const int argc, const char *argv[])
                         out = argv[i + 1];
                         i++;
                     }
+                    else if (cur == "--jobs")
+                    {
+                        if (i + 1 >= argc)
+                        {
+                            throw runtime_error("--jobs must be followed by a number of jobs");
+                        }
+
+                        jobs = getJobCount(cur, argv[i + 1]);
+                        i++;
+                    }
+                    else if (cur == "--incr")
+                    {
+                        incremental = !incremental;
+                    }
+                    else if (cur == "--lazy")
+                    {
+                        lazyInstantiation = !lazyInstantiation;
+                    }
                     else if (cur == "--prettify")
                     {
                         prettify = !prettify;
@@ -357,6 +396,21 @@ int main(const int argc, const char *argv[])
                                 compile = doLink = false;
                             }
                             break;
+                        case 'j':
+                            if (i + 1 >= argc)
+                            {
+                                throw runtime_error("-j must be followed by a number of jobs");
+                            }
+
+                            jobs = getJobCount("-j", argv[i + 1]);
+                            i++;
+                            break;
+                        case 'I':
+                            incremental = !incremental;
+                            break;
+                        case 'L':
+                            lazyInstantiation = !lazyInstantiation;
+                            break;
                         case 'o':
                             if (i + 1 >= argc)
                             {
@@ -493,6 +547,13 @@ int main(const int argc, const char *argv[])
             system("rm -rf " COMPILED_PATH "/*.c " COMPILED_PATH "/*.h " COMPILED_PATH "/*.txt " COMPILED_PATH
                    "/*.oak");
 
+            // Then the least recently used saved file states (-I)
+            unsigned long long size = getSize(COMPILED_PATH);
+            if (size > MAX_CACHE_KB)
+            {
+                purgeFileStates(size - MAX_CACHE_KB);
+            }
+
             if (getSize(COMPILED_PATH) > MAX_CACHE_KB)
             {
                 cout << tags::yellow_bold << DB_INFO << "Performing full cache purge\n" << tags::reset;
@@ -568,7 +629,7 @@ int main(const int argc, const char *argv[])
 
                 if (compile)
                 {
-                    smartSystem("mkdir -p .oak_build");
+                    filesystem::create_directories(".oak_build");
 
                     if (debug)
                     {
@@ -577,25 +638,7 @@ int main(const int argc, const char *argv[])
                              << tags::reset;
                     }
 
-                    string rootCommand = C_COMPILER " -c ";
-
-                    for (string flag : cflags)
-                    {
-                        rootCommand += flag + " ";
-                    }
-
-                    for (string source : cppSources)
-                    {
-                        string command = rootCommand + source + " -o " + source + ".o";
-
-                        if (debug)
-                        {
-                            cout << "System call `" << command << "`\n";
-                        }
-
-                        throw_assert(system(command.c_str()) == 0);
-                        objects.insert(source + ".o");
-                    }
+                    compileSources();
 
                     if (doLink)
                     {
@@ -606,23 +649,7 @@ int main(const int argc, const char *argv[])
                                  << tags::reset;
                         }
 
-                        string command = LINKER " -o " + out + " ";
-                        for (string object : objects)
-                        {
-                            command += object + " ";
-                        }
-
-                        for (string flag : cflags)
-                        {
-                            command += flag + " ";
-                        }
-
-                        if (debug)
-                        {
-                            cout << "System call `" << command << "`\n";
-                        }
-
-                        throw_assert(system(command.c_str()) == 0);
+                        linkObjects(out);
                     }
                 }
 
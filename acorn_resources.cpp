@@ -12,9 +12,17 @@ GPLv3 held by author
 #include "sequence_resources.hpp"
 #include "tags.hpp"
 #include <bits/chrono.h>
+#include <cerrno>
 #include <chrono>
+#include <csignal>
+#include <fcntl.h>
 #include <filesystem>
+#include <poll.h>
 #include <ratio>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 // Settings
 bool debug = false;
@@ -24,9 +32,10 @@ bool alwaysDump = false;
 bool manual = false;
 bool ignoreSyntaxErrors = false;
 bool timeAnalysis = false;
-bool isMacroCall = false;
+unsigned int jobs = 1;
 
 set<string> visitedFiles;
+set<string> loadedFiles;
 set<string> cppSources;
 set<string> objects;
 set<string> cflags;
@@ -36,6 +45,37 @@ vector<unsigned long long> phaseTimes;
 
 string debugTreePrefix = "";
 
+// How many files being saved for -I are currently open; Files
+// they include are saved along with them
+static unsigned int fileStateDepth = 0;
+
+// The file the include being saved was included into, and
+// whether the include depends on its name: Its text uses
+// prev_file!, or it tried to include that file again
+static string fileStateIncluder = "";
+static bool fileStateUsesIncluder = false;
+
+// Counts a file towards fileStateDepth until it is left, even by
+// an exception
+struct fileStateScope
+{
+    bool entered = false;
+
+    void enter()
+    {
+        entered = true;
+        fileStateDepth++;
+    }
+
+    ~fileStateScope()
+    {
+        if (entered)
+        {
+            fileStateDepth--;
+        }
+    }
+};
+
 // Prints the cumulative disk usage of Oak (in human-readable)
 void getDiskUsage()
 {
@@ -54,6 +94,410 @@ void getDiskUsage()
     return;
 }
 
+// A running compiler process
+struct job
+{
+    pid_t pid;
+    int output; // -1 if not captured
+    string command, log;
+};
+
+// Stops and reaps every job still running, so that runJobs can
+// throw without leaving children or pipes behind
+static void stopJobs(vector<job> &Running)
+{
+    for (job &j : Running)
+    {
+        if (j.output != -1)
+        {
+            close(j.output);
+        }
+        kill(j.pid, SIGTERM);
+    }
+
+    for (job &j : Running)
+    {
+        while (waitpid(j.pid, nullptr, 0) < 0 && errno == EINTR)
+        {
+        }
+    }
+
+    Running.clear();
+    return;
+}
+
+void runJobs(const vector<string> &Commands)
+{
+    bool capture = jobs > 1;
+    vector<job> running;
+    vector<string> failures;
+    size_t next = 0;
+
+    while (next < Commands.size() || !running.empty())
+    {
+        // Fill any free slots
+        while (next < Commands.size() && running.size() < max(jobs, 1u))
+        {
+            job toAdd;
+            toAdd.command = Commands[next];
+            toAdd.output = -1;
+            next++;
+
+            if (debug)
+            {
+                cout << "System call `" << toAdd.command << "`\n";
+            }
+
+            int fds[2];
+            if (capture && pipe2(fds, O_CLOEXEC) != 0)
+            {
+                stopJobs(running);
+                throw runtime_error("Failed to create pipe for command '" + toAdd.command + "'");
+            }
+
+            toAdd.pid = fork();
+            if (toAdd.pid < 0)
+            {
+                if (capture)
+                {
+                    close(fds[0]);
+                    close(fds[1]);
+                }
+
+                stopJobs(running);
+                throw runtime_error("Failed to start command '" + toAdd.command + "'");
+            }
+            else if (toAdd.pid == 0)
+            {
+                if (capture)
+                {
+                    dup2(fds[1], STDOUT_FILENO);
+                    dup2(fds[1], STDERR_FILENO);
+                }
+
+                execl("/bin/sh", "sh", "-c", toAdd.command.c_str(), (char *)nullptr);
+                _exit(127);
+            }
+
+            if (capture)
+            {
+                close(fds[1]);
+                toAdd.output = fds[0];
+            }
+
+            running.push_back(toAdd);
+        }
+
+        // Wait for the next job to finish
+        int done = 0;
+        if (capture)
+        {
+            vector<pollfd> fds;
+            for (const job &j : running)
+            {
+                fds.push_back(pollfd{j.output, POLLIN, 0});
+            }
+
+            if (poll(fds.data(), fds.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                stopJobs(running);
+                throw runtime_error("Failed to wait for commands");
+            }
+
+            done = -1;
+            for (size_t k = 0; k < fds.size() && done == -1; k++)
+            {
+                if (fds[k].revents == 0)
+                {
+                    continue;
+                }
+
+                char buffer[4096];
+                ssize_t count = read(running[k].output, buffer, sizeof(buffer));
+                if (count > 0)
+                {
+                    running[k].log.append(buffer, count);
+                }
+                else if (count == 0 || errno != EINTR)
+                {
+                    done = k;
+                }
+            }
+
+            if (done == -1)
+            {
+                continue;
+            }
+
+            close(running[done].output);
+            cout << running[done].log << flush;
+        }
+
+        int status = 0;
+        while (waitpid(running[done].pid, &status, 0) < 0 && errno == EINTR)
+        {
+        }
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            failures.push_back(running[done].command);
+        }
+
+        running.erase(running.begin() + done);
+    }
+
+    if (!failures.empty())
+    {
+        string message = "Command failed: '" + failures[0] + "'";
+        if (failures.size() > 1)
+        {
+            message += " (and " + to_string(failures.size() - 1) + " more)";
+        }
+
+        throw runtime_error(message);
+    }
+
+    return;
+}
+
+void compileSources()
+{
+    vector<string> commands;
+    string rootCommand = C_COMPILER " -c ";
+
+    for (string flag : cflags)
+    {
+        rootCommand += flag + " ";
+    }
+
+    for (string source : cppSources)
+    {
+        commands.push_back(rootCommand + source + " -o " + source + ".o");
+        objects.insert(source + ".o");
+    }
+
+    // Package interface objects, if out of date with their sources
+    set<string> toCompile;
+    for (const string &object : objects)
+    {
+        if (object.size() < 3 || object.substr(object.size() - 2) != ".o")
+        {
+            continue;
+        }
+
+        string source = object.substr(0, object.size() - 2) + ".c";
+        if (cppSources.count(source) != 0 || !filesystem::exists(source) || !isSourceNewer(source, object))
+        {
+            continue;
+        }
+
+        toCompile.insert(source);
+    }
+
+    for (const string &source : toCompile)
+    {
+        string local = source;
+        for (char &c : local)
+        {
+            if (c == '/')
+            {
+                c = '_';
+            }
+        }
+        local = ".oak_build/pkg" + local.substr(0, local.size() - 2) + ".o";
+
+        if (isSourceNewer(source, local))
+        {
+            commands.push_back(rootCommand + source + " -o " + local);
+        }
+
+        objects.erase(source.substr(0, source.size() - 2) + ".o");
+        objects.insert(local);
+    }
+
+    runJobs(commands);
+
+    return;
+}
+
+void linkObjects(const string &Out)
+{
+    string command = LINKER " -o " + Out + " ";
+    for (string object : objects)
+    {
+        command += object + " ";
+    }
+
+    for (string flag : cflags)
+    {
+        command += flag + " ";
+    }
+
+    if (debug)
+    {
+        cout << "System call `" << command << "`\n";
+    }
+
+    throw_assert(system(command.c_str()) == 0);
+
+    return;
+}
+
+/*
+A source file, mapped read-only into memory. Its text always
+ends with a newline; If the file does not, or it cannot be
+mapped, it is read into a string instead.
+*/
+class sourceFile
+{
+  public:
+    sourceFile(const string &Path)
+    {
+        int fd = open(Path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        opened = true;
+
+        struct stat info;
+        if (fstat(fd, &info) == 0)
+        {
+            fileSize = info.st_size;
+            modified = info.st_mtim;
+        }
+
+        if (fileSize > 0 && S_ISREG(info.st_mode))
+        {
+            mappedSize = info.st_size;
+            mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (mapped == MAP_FAILED)
+            {
+                mapped = nullptr;
+                mappedSize = 0;
+            }
+            else
+            {
+                madvise(mapped, mappedSize, MADV_SEQUENTIAL);
+                view = string_view((const char *)mapped, mappedSize);
+            }
+        }
+
+        if (mapped == nullptr)
+        {
+            char buffer[4096];
+            ssize_t count;
+            while ((count = read(fd, buffer, sizeof(buffer))) > 0)
+            {
+                copy.append(buffer, count);
+            }
+
+            view = copy;
+        }
+
+        ::close(fd);
+
+        if (!view.empty() && view.back() != '\n')
+        {
+            if (mapped != nullptr)
+            {
+                copy.assign(view);
+                close();
+            }
+
+            copy.push_back('\n');
+            view = copy;
+        }
+
+        return;
+    }
+
+    ~sourceFile()
+    {
+        close();
+        return;
+    }
+
+    bool is_open() const
+    {
+        return opened;
+    }
+
+    const string_view &text() const
+    {
+        return view;
+    }
+
+    // True if Size and Modified are still this file's
+    bool isUnchanged(const off_t &Size, const struct timespec &Modified) const
+    {
+        return Size == fileSize && Modified.tv_sec == modified.tv_sec && Modified.tv_nsec == modified.tv_nsec;
+    }
+
+    // Unmaps the file. Text which was copied is kept.
+    void close()
+    {
+        if (mapped != nullptr)
+        {
+            munmap(mapped, mappedSize);
+            mapped = nullptr;
+            mappedSize = 0;
+            view = copy;
+        }
+
+        return;
+    }
+
+    off_t size() const
+    {
+        return fileSize;
+    }
+    const struct timespec &lastModified() const
+    {
+        return modified;
+    }
+
+  protected:
+    bool opened = false;
+    void *mapped = nullptr;
+    size_t mappedSize = 0;
+    off_t fileSize = 0;
+    struct timespec modified = {0, 0};
+    string copy;
+    string_view view;
+};
+
+/*
+The tokens of every file this process has lexed. A macro which
+is translated in process includes mostly what its parent did,
+starting with std, and takes those files' tokens from here
+rather than lexing them again.
+*/
+struct __lexedFile
+{
+    off_t size = 0;
+    struct timespec modified = {0, 0};
+    vector<token> tokens;
+};
+static map<string, __lexedFile> lexedFiles;
+
+string getRealName(const string &From)
+{
+    if (From.find("/") == string::npos)
+    {
+        return From;
+    }
+
+    return From.substr(From.find("/") + 1);
+}
+
 void doFile(const string &From)
 {
     // chrono::high_resolution_clock::time_point global_start, global_end;
@@ -68,12 +512,10 @@ void doFile(const string &From)
         }
     }
 
-    system("mkdir -p .oak_build");
+    filesystem::create_directories(".oak_build");
 
     int curPhase = 0;
 
-    const static set<string> compilerMacros = {"include!", "package!", "link!", "flag!"};
-
     chrono::_V2::system_clock::time_point start, end;
 
     // Clear active rules
@@ -85,7 +527,10 @@ void doFile(const string &From)
     curLine = 1;
     curFile = From;
 
-    vector<string> lexed, lexedCopy;
+    tokenBuffer lexed;
+    vector<token> lexedCopy;
+
+    fileStateBase stateBase;
 
     preprocDefines["prev_file!"] = (oldFile == "" ? "\"NULL\"" : ("\"" + oldFile + "\""));
     preprocDefines["file!"] = '"' + From + '"';
@@ -114,20 +559,14 @@ void doFile(const string &From)
 
     try
     {
+        fileStateScope stateScope;
+
         if (From.size() < 4 || From.substr(From.size() - 4) != ".oak")
         {
             cout << tags::yellow_bold << "Warning! File '" << From << "' is not a .oak file.\n" << tags::reset;
         }
 
-        string realName;
-        if (From.find("/") == string::npos)
-        {
-            realName = From;
-        }
-        else
-        {
-            realName = From.substr(From.find("/") + 1);
-        }
+        string realName = getRealName(From);
 
         for (char c : realName)
         {
@@ -142,6 +581,11 @@ void doFile(const string &From)
 
         if (visitedFiles.count(realName) != 0)
         {
+            if (fileStateDepth != 0 && getRealName(fileStateIncluder) == realName)
+            {
+                fileStateUsesIncluder = true;
+            }
+
             if (debug)
             {
                 cout << debugTreePrefix << "Skipping repeated file '" << From << "'\n";
@@ -151,6 +595,28 @@ void doFile(const string &From)
             return;
         }
 
+        // Reload an included file if neither it nor what it was
+        // included into has changed
+        if (incremental && oldFile != "" && fileStateDepth == 0)
+        {
+            stateBase = getFileStateBase(From, oldFile);
+
+            if (loadFileState(From, stateBase.key, oldFile))
+            {
+                if (debug)
+                {
+                    cout << debugTreePrefix << "Reloaded file '" << From << "' from " FILE_STATE_PATH "\n";
+                }
+                curFile = oldFile;
+                curLine = oldLineNum;
+                return;
+            }
+
+            stateScope.enter();
+            fileStateIncluder = oldFile;
+            fileStateUsesIncluder = false;
+        }
+
         visitedFiles.insert(realName);
 
         if (debug)
@@ -160,7 +626,7 @@ void doFile(const string &From)
         }
 
         // A: Load file
-        ifstream file(From, ios::in | ios::ate);
+        sourceFile file(From);
         if (!file.is_open())
         {
             curFile = oldFile;
@@ -168,26 +634,13 @@ void doFile(const string &From)
             throw runtime_error("Could not open source file '" + From + "'");
         }
 
-        long long size = file.tellg();
-
-        file.clear();
-        file.seekg(0, ios::beg);
-
-        size -= file.tellg();
-
-        string text, line;
-
-        text.reserve(size);
-        line.reserve(64);
+        loadedFiles.insert(From);
 
-        while (getline(file, line))
+        if (stateScope.entered && file.text().find("prev_file!") != string::npos)
         {
-            text.append(line);
-            text.push_back('\n');
+            fileStateUsesIncluder = true;
         }
 
-        file.close();
-
         // B: Syntax check
 
         if (debug)
@@ -198,7 +651,7 @@ void doFile(const string &From)
 
         if (!(ignoreSyntaxErrors || isMacroCall))
         {
-            ensureSyntax(text, true);
+            ensureSyntax(file.text(), true);
         }
 
         if (debug)
@@ -216,8 +669,17 @@ void doFile(const string &From)
             start = chrono::high_resolution_clock::now();
         }
 
-        lexed = lex(text);
-        lexedCopy = lexed;
+        __lexedFile &cached = lexedFiles[From];
+        if (cached.tokens.empty() || !file.isUnchanged(cached.size, cached.modified))
+        {
+            cached.size = file.size();
+            cached.modified = file.lastModified();
+            cached.tokens = lex(file.text());
+        }
+
+        lexedCopy = cached.tokens;
+        lexed = lexedCopy;
+        file.close();
 
         if (debug)
         {
@@ -237,9 +699,9 @@ void doFile(const string &From)
 
         for (int i = 1; i + 1 < lexed.size(); i++)
         {
-            if (lexed[i].back() == '!' && lexed[i] != "!" && lexed[i - 1] == "let")
+            if (lexed[i].back() == '!' && lexed[i] != tok::bang && lexed[i - 1] == tok::let_kw)
             {
-                if (lexed[i + 1] != "=")
+                if (lexed[i + 1] != tok::assign)
                 {
                     // Full macro
 
@@ -259,40 +721,40 @@ void doFile(const string &From)
                     contents = "let main";
 
                     i--;
-                    lexed.erase(lexed.begin() + i); // Let
-                    lexed.erase(lexed.begin() + i); // Name
+                    lexed.erase(i); // Let
+                    lexed.erase(i); // Name
 
-                    while (lexed.size() >= i && lexed[i] != "{" && lexed[i] != ";")
+                    while (lexed.size() >= i && lexed[i] != tok::lbrace && lexed[i] != tok::semicolon)
                     {
                         contents += " " + lexed[i];
-                        lexed.erase(lexed.begin() + i);
+                        lexed.erase(i);
                     }
 
                     int count = 1;
-                    lexed.erase(lexed.begin() + i);
+                    unsigned int bodyLine = lexed[i].line;
+                    lexed.erase(i);
                     contents += "\n{";
 
                     while (count != 0)
                     {
-                        if (lexed[i] == "{")
+                        if (lexed[i] == tok::lbrace)
                         {
                             count++;
                         }
-                        else if (lexed[i] == "}")
+                        else if (lexed[i] == tok::rbrace)
                         {
                             count--;
                         }
 
-                        if (lexed[i].size() < 2 || lexed[i].substr(0, 2) != "//")
-                        {
-                            contents += " " + lexed[i];
-                        }
-                        else
+                        // Keep the body's line breaks
+                        while (bodyLine < lexed[i].line)
                         {
                             contents += "\n";
+                            bodyLine++;
                         }
 
-                        lexed.erase(lexed.begin() + i);
+                        contents += " " + lexed[i];
+                        lexed.erase(i);
                     }
 
                     macros[name] = contents;
@@ -317,19 +779,19 @@ void doFile(const string &From)
 
                     // Erase as needed
                     i--;
-                    lexed.erase(lexed.begin() + i); // Let
-                    lexed.erase(lexed.begin() + i); // Name!
-                    lexed.erase(lexed.begin() + i); // =
+                    lexed.erase(i); // Let
+                    lexed.erase(i); // Name!
+                    lexed.erase(i); // =
 
                     // Scrape until next semicolon
                     string contents = "";
-                    while (lexed[i] != ";")
+                    while (lexed[i] != tok::semicolon)
                     {
                         contents.append(lexed[i]);
-                        lexed.erase(lexed.begin() + i);
+                        lexed.erase(i);
                     }
 
-                    lexed.erase(lexed.begin() + i); // ;
+                    lexed.erase(i); // ;
 
                     // Insert
                     preprocDefines[name] = contents;
@@ -359,10 +821,10 @@ void doFile(const string &From)
 
             for (int i = 0; i < lexed.size(); i++)
             {
-                if (lexed[i] != "!" && lexed[i].back() == '!')
+                if (lexed[i] != tok::bang && lexed[i].back() == '!')
                 {
                     // File handling / translation unit macros
-                    if (lexed[i] == "include!")
+                    if (lexed[i] == tok::include_macro)
                     {
                         vector<string> args = getMacroArgs(lexed, i);
 
@@ -408,7 +870,7 @@ void doFile(const string &From)
 
                         i--;
                     }
-                    else if (lexed[i] == "link!")
+                    else if (lexed[i] == tok::link_macro)
                     {
                         vector<string> args = getMacroArgs(lexed, i);
 
@@ -443,7 +905,7 @@ void doFile(const string &From)
                         }
                         i--;
                     }
-                    else if (lexed[i] == "flag!")
+                    else if (lexed[i] == tok::flag_macro)
                     {
                         vector<string> args = getMacroArgs(lexed, i);
 
@@ -471,7 +933,7 @@ void doFile(const string &From)
                         }
                         i--;
                     }
-                    else if (lexed[i] == "package!")
+                    else if (lexed[i] == tok::package_macro)
                     {
                         vector<string> args = getMacroArgs(lexed, i);
                         vector<string> files;
@@ -527,14 +989,14 @@ void doFile(const string &From)
                     {
                         // Non-compiler macro definition
                         // Nested stuff may be allowed within
-                        if (i > 0 && lexed[i - 1] == "let")
+                        if (i > 0 && lexed[i - 1] == tok::let_kw)
                         {
-                            while (lexed.size() >= i && lexed[i] != "{" && lexed[i] != ";")
+                            while (lexed.size() >= i && lexed[i] != tok::lbrace && lexed[i] != tok::semicolon)
                             {
                                 i++;
                             }
 
-                            if (lexed[i] == ";")
+                            if (lexed[i] == tok::semicolon)
                             {
                                 i++;
                             }
@@ -545,11 +1007,11 @@ void doFile(const string &From)
 
                                 while (count != 0)
                                 {
-                                    if (lexed[i] == "{")
+                                    if (lexed[i] == tok::lbrace)
                                     {
                                         count++;
                                     }
-                                    else if (lexed[i] == "}")
+                                    else if (lexed[i] == tok::rbrace)
                                     {
                                         count--;
                                     }
@@ -590,7 +1052,8 @@ void doFile(const string &From)
             compilerMacrosLeft = false;
             for (const auto &item : lexed)
             {
-                if (compilerMacros.count(item) != 0)
+                if (item == tok::include_macro || item == tok::package_macro || item == tok::link_macro ||
+                    item == tok::flag_macro)
                 {
                     compilerMacrosLeft = true;
                     break;
@@ -609,104 +1072,99 @@ void doFile(const string &From)
         for (int i = 0; i < lexed.size(); i++)
         {
             // We can assume that no macro definitions remain
-            if (lexed[i] != "!" && lexed[i].back() == '!' && i + 1 < lexed.size() && lexed[i + 1] == "(")
+            if (lexed[i] != tok::bang && lexed[i].back() == '!' && i + 1 < lexed.size() && lexed[i + 1] == tok::lparen)
             {
                 // Special cases: Memory macros
-                if (lexed[i] == "alloc!" || lexed[i] == "free!" || lexed[i] == "free_arr!")
+                if (lexed[i] == tok::alloc_macro || lexed[i] == tok::free_macro || lexed[i] == tok::free_arr_macro)
                 {
                     continue;
                 }
 
                 // Another special case: Erasure macro
-                else if (lexed[i] == "erase!")
+                else if (lexed[i] == tok::erase_macro)
                 {
                     continue;
                 }
 
                 // More special cases
-                else if (lexed[i] == "c_print!")
+                else if (lexed[i] == tok::c_print_macro)
                 {
                     continue;
                 }
-                else if (lexed[i] == "c_panic!")
+                else if (lexed[i] == tok::c_panic_macro)
                 {
                     continue;
                 }
-                else if (lexed[i] == "c_sys!")
+                else if (lexed[i] == tok::c_sys_macro)
                 {
                     continue;
                 }
 
                 // More special cases: Rule macros
-                else if (lexed[i] == "new_rule!" || lexed[i] == "use_rule!" || lexed[i] == "rem_rule!" ||
-                         lexed[i] == "bundle_rule!")
+                else if (lexed[i] == tok::new_rule_macro || lexed[i] == tok::use_rule_macro || lexed[i] == tok::rem_rule_macro ||
+                         lexed[i] == tok::bundle_rule_macro)
                 {
                     continue;
                 }
 
                 // Extra bonus special cases: Typing and sizing
-                else if (lexed[i] == "type!" || lexed[i] == "size!")
+                else if (lexed[i] == tok::type_macro || lexed[i] == tok::size_macro)
                 {
                     continue;
                 }
 
                 // Raw C insertion
-                else if (lexed[i] == "raw_c!")
+                else if (lexed[i] == tok::raw_c_macro)
                 {
                     continue;
                 }
 
                 // Super secret special cases: Pointer manipulation
-                else if (lexed[i] == "ptrcpy!" || lexed[i] == "ptrarr!")
+                else if (lexed[i] == tok::ptrcpy_macro || lexed[i] == tok::ptrarr_macro)
                 {
                     continue;
                 }
 
                 string name = lexed[i];
+                unsigned int callLine = lexed[i].line;
 
                 // Erases all trace of the call in the process
                 vector<string> args = getMacroArgs(lexed, i);
 
                 string output = callMacro(name, args, debug);
-                vector<string> lexedOutput = lex(output);
+                tokenBuffer lexedOutput = lex(output);
 
                 // Reset preproc defs, as they tend to break w/ macros
                 preprocDefines["prev_file!"] = (oldFile == "" ? "\"NULL\"" : ("\"" + oldFile + "\""));
                 preprocDefines["file!"] = '"' + From + '"';
 
-                // Remove lines
+                // Place the output on the line of the call
+                unsigned int outputLine = 1;
                 for (int ind = 0; ind < lexedOutput.size(); ind++)
                 {
-                    if (lexedOutput[ind].size() > 1 && lexedOutput[ind].substr(0, 2) == "//")
+                    if (lexedOutput[ind].line > outputLine)
                     {
-                        if (lexedOutput[ind].size() > 11 && lexedOutput[ind].substr(0, 11) == "//__LINE__=")
-                        {
-                            preprocDefines["line!"] = lexedOutput[ind].substr(11);
-                        }
-
-                        lexedOutput.erase(lexedOutput.begin() + ind);
+                        outputLine = lexedOutput[ind].line;
+                        preprocDefines["line!"] = to_string(outputLine);
                     }
 
                     // Preproc defines subs
-                    else if (preprocDefines.count(lexedOutput[ind]) != 0)
+                    if (preprocDefines.count(lexedOutput[ind]) != 0)
                     {
-                        vector<string> lexedDef = lex(preprocDefines[lexedOutput[ind]]);
-                        lexedOutput.erase(lexedOutput.begin() + ind);
+                        vector<token> lexedDef = lex(preprocDefines[lexedOutput[ind]]);
+                        lexedOutput.erase(ind);
 
-                        for (int j = lexedDef.size() - 1; j >= 0; j--)
-                        {
-                            lexedOutput.insert(lexedOutput.begin() + ind, lexedDef[j]);
-                        }
+                        lexedOutput.insert(ind, lexedDef);
 
                         ind--;
+                        continue;
                     }
+
+                    lexedOutput[ind].line = callLine;
                 }
 
                 // Insert the new code
-                for (int j = lexedOutput.size() - 1; j >= 0; j--)
-                {
-                    lexed.insert(lexed.begin() + i, lexedOutput[j]);
-                }
+                lexed.insert(i, lexedOutput.toVector());
 
                 // Since we do not change i, this new code will be scanned next.
             }
@@ -727,24 +1185,26 @@ void doFile(const string &From)
         }
 
         preprocDefines["line!"] = "1";
+        unsigned int preprocLine = 1;
         for (int i = 0; i < lexed.size(); i++)
         {
-            if (lexed[i].size() >= 2 && lexed[i].substr(0, 2) == "//")
+            if (lexed[i].line != 0 && lexed[i].line != preprocLine)
             {
-                // Line update special symbol
-                string newLineNum = lexed[i].substr(11);
-                preprocDefines["line!"] = newLineNum;
+                preprocLine = lexed[i].line;
+                preprocDefines["line!"] = to_string(preprocLine);
             }
-            else if (preprocDefines.count(lexed[i]) != 0)
-            {
-                vector<string> lexedDef = lex(preprocDefines[lexed[i]]);
-                lexed.erase(lexed.begin() + i);
 
-                for (int j = lexedDef.size() - 1; j >= 0; j--)
+            if (preprocDefines.count(lexed[i]) != 0)
+            {
+                vector<token> lexedDef = lex(preprocDefines[lexed[i]]);
+                for (token &t : lexedDef)
                 {
-                    lexed.insert(lexed.begin() + i, lexedDef[j]);
+                    t.line = lexed[i].line;
                 }
 
+                lexed.erase(i);
+                lexed.insert(i, lexedDef);
+
                 i--;
             }
         }
@@ -779,7 +1239,7 @@ void doFile(const string &From)
             start = chrono::high_resolution_clock::now();
         }
 
-        sequence fileSeq = createSequence(lexed);
+        sequence fileSeq = createSequence(lexed.toVector());
 
         if (debug)
         {
@@ -896,6 +1356,11 @@ void doFile(const string &From)
     // elapsedms += chrono::duration_cast<chrono::milliseconds>(global_end - global_start).count();
     // cout << DB_INFO << curFile << "\t" << elapsedms << " ms\n";
 
+    if (stateBase.key != "")
+    {
+        saveFileState(From, stateBase, fileStateUsesIncluder ? oldFile : "");
+    }
+
     curLine = oldLineNum;
     curFile = oldFile;
 
@@ -978,7 +1443,7 @@ void printSyntaxError(const string &what, const vector<char> &curLineVec, const
     return;
 }
 
-void ensureSyntax(const string &text, const bool &fatal)
+void ensureSyntax(const string_view &text, const bool &fatal)
 {
     vector<char> curLineVec;
     curLineVec.reserve(96);
@@ -18,6 +18,7 @@ GPLv3 held by author
 #include <vector>
 
 #include "document.hpp"
+#include "incremental.hpp"
 #include "lexer.hpp"
 #include "macros.hpp"
 #include "op_sub.hpp"
@@ -51,8 +52,8 @@ using namespace std;
 
 /*
 Remaining options:
- - "bfgjktyz"
- - "BCFGHIJKLNPVWXYZ"
+ - "bfgktyz"
+ - "BCFGHJKNPVWXYZ"
 */
 
 const string helpText = "Acorn - Oak Standard Translator\n"
@@ -70,7 +71,10 @@ const string helpText = "Acorn - Oak Standard Translator\n"
                         " -g    | --exe_debug | Use LLVM debug flag\n"
                         " -h    | --help      | Show this\n"
                         " -i    | --install   | Install a package\n"
+                        " -I    | --incr      | Reload unchanged includes\n"
+                        " -j    | --jobs      | Run N C compiles at once\n"
                         " -l    | --link      | Produce executables\n"
+                        " -L    | --lazy      | Instantiate methods on use\n"
                         " -m    | --manual    | Produce a .md doc\n"
                         " -M    |             | Used for macros\n"
                         " -n    | --no_save   | Produce nothing\n"
@@ -91,17 +95,40 @@ const string helpText = "Acorn - Oak Standard Translator\n"
                         " -w    | --new       | Create a new package\n"
                         " -x    | --syntax    | Ignore syntax errors\n";
 
-extern bool debug, compile, doLink, alwaysDump, manual, ignoreSyntaxErrors, isMacroCall;
+extern bool debug, compile, doLink, alwaysDump, manual, ignoreSyntaxErrors;
+
+// The most compiler processes to run at once (-j)
+extern unsigned int jobs;
 extern set<string> visitedFiles, cppSources, objects, cflags;
+
+// The path of every source file doFile has read
+extern set<string> loadedFiles;
 extern map<string, string> preprocDefines;
 extern vector<unsigned long long> phaseTimes;
 
 // Prints the cumulative disk usage of Oak (in human-readable)
 void getDiskUsage();
 
+// The name a file is entered under in visitedFiles
+string getRealName(const string &From);
+
 void doFile(const string &From);
 
+// Runs shell commands, up to jobs at a time. With more than
+// one job, each command's output is collected and printed
+// whole once it finishes. Throws after all have finished if
+// any of them failed.
+void runJobs(const vector<string> &Commands);
+
+// Compiles every file in cppSources into objects, in parallel.
+// Package objects in objects whose C source is newer are
+// rebuilt into .oak_build alongside them.
+void compileSources();
+
+// Links objects into the executable Out
+void linkObjects(const string &Out);
+
 void makePackage(const string &Name);
-void ensureSyntax(const string &text, const bool &fatal = true);
+void ensureSyntax(const string_view &text, const bool &fatal = true);
 
 #endif
@@ -8,17 +8,70 @@ Jordan Dehmel, 2023
 #include "generics.hpp"
 #include "symbol_table.hpp"
 #include "type_builder.hpp"
+#include <unordered_map>
+#include <unordered_set>
 
 // External definition of createSequence, defined in sequence.cpp
 // This avoids circular dependencies
-extern sequence createSequence(const vector<string> &From);
+extern sequence createSequence(const vector<token> &From);
 
 // A pair of <name, number_of_generics> maps to a vector of symbols within
 map<string, vector<genericInfo>> generics;
 
+bool lazyInstantiation = false;
+map<string, vector<pendingInstance>> pendingInstances;
+
+// True while the post block of an instantiation is sequenced
+static bool inPostBlock = false;
+
+unordered_map<string, vector<__instanceIndex>> instanceIndices;
+unordered_map<string, string> instantiations;
+
+static void appendID(string &Key, const unsigned int &ID)
+{
+    Key.append((const char *)&ID, sizeof(ID));
+    return;
+}
+
+// Packs substitutions by their interned token IDs
+static string getSubsKey(const vector<vector<token>> &Subs)
+{
+    string key;
+    for (const auto &sub : Subs)
+    {
+        appendID(key, -1);
+        for (const token &t : sub)
+        {
+            appendID(key, t.id);
+        }
+    }
+
+    return key;
+}
+
+// Returns true if the candidate at Index of generics[What] has
+// already been instantiated with the substitutions in SubsKey
+static bool hasInstance(const string &What, const size_t &Index, const genericInfo &Candidate, const string &SubsKey)
+{
+    vector<__instanceIndex> &indices = instanceIndices[What];
+    if (indices.size() <= Index)
+    {
+        indices.resize(Index + 1);
+    }
+
+    __instanceIndex &index = indices[Index];
+    while (index.indexed < Candidate.instances.size())
+    {
+        index.keys.insert(getSubsKey(Candidate.instances[index.indexed]));
+        index.indexed++;
+    }
+
+    return index.keys.count(SubsKey) != 0;
+}
+
 // Returns true if template substitution would make the two typeVecs the same
-bool checkTypeVec(const vector<string> &candidateTypeVec, const vector<string> &genericTypeVec,
-                  const vector<string> &genericNames, const vector<vector<string>> &substitutions)
+bool checkTypeVec(const vector<token> &candidateTypeVec, const vector<token> &genericTypeVec,
+                  const vector<token> &genericNames, const vector<vector<token>> &substitutions)
 {
     if (genericNames.size() != substitutions.size())
     {
@@ -38,10 +91,10 @@ bool checkTypeVec(const vector<string> &candidateTypeVec, const vector<string> &
     }
 
     // Build substitution table
-    map<string, vector<string>> subMap;
+    map<string, vector<token>> subMap;
     for (int i = 0; i < genericNames.size(); i++)
     {
-        subMap[genericNames[i]] = vector<string>();
+        subMap[genericNames[i]] = vector<token>();
         for (auto item : substitutions[i])
         {
             subMap[genericNames[i]].push_back(item);
@@ -88,7 +141,7 @@ bool checkTypeVec(const vector<string> &candidateTypeVec, const vector<string> &
                 j++;
             }
 
-            vector<string> remaining;
+            vector<token> remaining;
             for (int k = j; k < subMap[symb].size(); k++)
             {
                 remaining.push_back(subMap[symb][k]);
@@ -167,67 +220,73 @@ bool typeIsPrefixOfAny(const Type &t, const vector<__multiTableSymbol> &candidat
     return false;
 }
 
-// Returns true if two instances are the same
-bool checkInstances(const vector<vector<string>> &a, const vector<vector<string>> &b)
+// Finds the generic names in a block. If a name is listed more
+// than once, its last substitution is the one used.
+static vector<genericSlot> findSlots(const vector<token> &block, const vector<token> &genericNames)
 {
-    if (a.size() != b.size())
-    {
-        return false;
-    }
+    vector<genericSlot> out;
 
-    for (int i = 0; i < a.size(); i++)
+    for (unsigned int pos = 0; pos < block.size(); pos++)
     {
-        if (a[i].size() != b[i].size())
+        for (unsigned int index = genericNames.size(); index > 0; index--)
         {
-            return false;
-        }
-
-        for (int j = 0; j < a[i].size(); j++)
-        {
-            if (a[i][j] != b[i][j])
+            if (block[pos] == genericNames[index - 1])
             {
-                return false;
+                out.push_back(genericSlot{pos, index - 1});
+                break;
             }
         }
     }
 
-    return true;
+    return out;
 }
 
-// Skips all error checking; DO NOT FEED THIS THINGS THAT MAY ALREADY HAVE INSTANCES
-// Returns true if it was successful
-string __instantiateGeneric(const string &what, genericInfo &info, const vector<vector<string>> &genericSubs)
+void findGenericSlots(genericInfo &info)
 {
-    // Build substitution table
-    map<string, vector<string>> substitutions;
-    for (int i = 0; i < genericSubs.size(); i++)
+    info.symbolSlots = findSlots(info.symbols, info.genericNames);
+    info.preSlots = findSlots(info.preBlock, info.genericNames);
+    info.postSlots = findSlots(info.postBlock, info.genericNames);
+    return;
+}
+
+// Writes block into out, with each slot replaced by its
+// substitution. Substituted tokens take the line of the slot.
+static void splice(const vector<token> &block, const vector<genericSlot> &slots,
+                   const vector<vector<token>> &genericSubs, vector<token> &out)
+{
+    out.clear();
+    out.reserve(block.size() + slots.size() * 4);
+
+    unsigned int prev = 0;
+    for (const auto &slot : slots)
     {
-        substitutions[info.genericNames[i]] = genericSubs[i];
+        out.insert(out.end(), block.begin() + prev, block.begin() + slot.pos);
+
+        for (auto s : genericSubs[slot.index])
+        {
+            s.line = block[slot.pos].line;
+            out.push_back(s);
+        }
+
+        prev = slot.pos + 1;
     }
 
-    vector<string> copy;
+    out.insert(out.end(), block.begin() + prev, block.end());
+    return;
+}
+
+// Skips all error checking; DO NOT FEED THIS THINGS THAT MAY ALREADY HAVE INSTANCES
+// Returns true if it was successful
+string __instantiateGeneric(const string &what, genericInfo &info, const vector<vector<token>> &genericSubs)
+{
+    vector<token> copy;
+    bool oldInPostBlock = inPostBlock;
+    inPostBlock = false;
 
     // Needs block (pre, so no functions)
     if (info.preBlock.size() != 0)
     {
-        // Create copy of pre block
-        copy.reserve(info.preBlock.size());
-        copy.assign(info.preBlock.begin(), info.preBlock.end());
-
-        // Iterate and mangle pre block
-        for (int i = 0; i < copy.size(); i++)
-        {
-            if (substitutions.count(copy[i]) != 0)
-            {
-                string temp = copy[i];
-                copy.erase(copy.begin() + i);
-                for (auto s : substitutions[temp])
-                {
-                    copy.insert(copy.begin() + i, s);
-                    i++;
-                }
-            }
-        }
+        splice(info.preBlock, info.preSlots, genericSubs, copy);
 
         try
         {
@@ -237,53 +296,20 @@ string __instantiateGeneric(const string &what, genericInfo &info, const vector<
         catch (exception &e)
         {
             // This is only a failure case for this template
+            inPostBlock = oldInPostBlock;
             return e.what();
         }
     }
 
-    // Make a copy of the template
-    copy.clear();
-    for (auto item : info.symbols)
-    {
-        if (substitutions.count(item) != 0)
-        {
-            for (auto subItem : substitutions[item])
-            {
-                copy.push_back(subItem);
-            }
-        }
-        else
-        {
-            copy.push_back(item);
-        }
-    }
-
-    // Call on substituted results
+    // Call on substituted template
+    splice(info.symbols, info.symbolSlots, genericSubs, copy);
     createSequence(copy);
 
     // Post block
     if (info.postBlock.size() != 0)
     {
-        copy.clear();
-
-        // Create copy of post block
-        copy.reserve(info.postBlock.size());
-        copy.assign(info.postBlock.begin(), info.postBlock.end());
-
-        // Iterate and mangle post block
-        for (int i = 0; i < copy.size(); i++)
-        {
-            if (substitutions.count(copy[i]) != 0)
-            {
-                string temp = copy[i];
-                copy.erase(copy.begin() + i);
-                for (auto s : substitutions[temp])
-                {
-                    copy.insert(copy.begin() + i, s);
-                    i++;
-                }
-            }
-        }
+        splice(info.postBlock, info.postSlots, genericSubs, copy);
+        inPostBlock = true;
 
         try
         {
@@ -293,16 +319,44 @@ string __instantiateGeneric(const string &what, genericInfo &info, const vector<
         catch (exception &e)
         {
             // This is only a failure case for this template
+            inPostBlock = oldInPostBlock;
             return e.what();
         }
     }
 
+    inPostBlock = oldInPostBlock;
     return "";
 }
 
-string instantiateGeneric(const string &what, const vector<vector<string>> &genericSubs, const vector<string> &typeVec)
+string instantiateGeneric(const string &what, const vector<vector<token>> &genericSubs, const vector<token> &typeVec)
 {
     // Get mangled version (only meaningful for struct instantiations)
+    string subsKey = getSubsKey(genericSubs);
+    string key = what;
+    key.push_back('\0');
+    for (const token &t : typeVec)
+    {
+        appendID(key, t.id);
+    }
+    key.append(subsKey);
+
+    // Under -L, functions named by post blocks wait until they
+    // are called. New and Del are exempt, since they are called
+    // implicitly.
+    if (lazyInstantiation && inPostBlock && what != "New" && what != "Del" &&
+        !(typeVec.size() == 1 && typeVec[0] == "struct"))
+    {
+        pendingInstances[what].push_back(pendingInstance{genericSubs, typeVec});
+        return mangleStruct(what, genericSubs);
+    }
+
+    // Anything which has been instantiated once still is
+    auto found = instantiations.find(key);
+    if (found != instantiations.end())
+    {
+        return found->second;
+    }
+
     string oldCurFile = curFile;
     int oldCurLine = curLine;
 
@@ -349,25 +403,14 @@ string instantiateGeneric(const string &what, const vector<vector<string>> &gene
             throw generic_error("Error! No template exists with which to instantiate template '" + what + "'.");
         }
 
-        for (auto &candidate : generics[what])
+        for (size_t candIndex = 0; candIndex < generics[what].size(); candIndex++)
         {
+            auto &candidate = generics[what][candIndex];
             curFile = candidate.originFile;
 
             if (checkTypeVec(typeVec, candidate.typeVec, candidate.genericNames, genericSubs))
             {
-                bool hasInstance = false;
-
-                // Search for existing instance here
-                for (auto instance : candidate.instances)
-                {
-                    if (checkInstances(instance, genericSubs))
-                    {
-                        hasInstance = true;
-                        break;
-                    }
-                }
-
-                if (!hasInstance)
+                if (!hasInstance(what, candIndex, candidate, subsKey))
                 {
                     candidate.instances.push_back(genericSubs);
                     string result = __instantiateGeneric(what, candidate, genericSubs);
@@ -445,12 +488,39 @@ string instantiateGeneric(const string &what, const vector<vector<string>> &gene
         throw generic_error("Error! Candidates exist for template '" + what + "', but none are viable.");
     }
 
+    instantiations[key] = mangleStr;
+
     // Return mangled version
     return mangleStr;
 }
 
-void addGeneric(const vector<string> &what, const string &name, const vector<string> &genericsList,
-                const vector<string> &typeVec, const vector<string> &preBlock, const vector<string> &postBlock)
+void instantiatePending(const string &name)
+{
+    auto found = pendingInstances.find(name);
+    if (found == pendingInstances.end() || found->second.empty())
+    {
+        return;
+    }
+
+    // Instantiation may defer more under this name, so take the
+    // list before starting
+    vector<pendingInstance> toInstantiate;
+    toInstantiate.swap(found->second);
+
+    bool oldInPostBlock = inPostBlock;
+    inPostBlock = false;
+
+    for (const auto &pending : toInstantiate)
+    {
+        instantiateGeneric(name, pending.genericSubs, pending.typeVec);
+    }
+
+    inPostBlock = oldInPostBlock;
+    return;
+}
+
+void addGeneric(const vector<token> &what, const string &name, const vector<token> &genericsList,
+                const vector<token> &typeVec, const vector<token> &preBlock, const vector<token> &postBlock)
 {
     genericInfo toAdd;
     toAdd.originFile = curFile;
@@ -503,6 +573,7 @@ void addGeneric(const vector<string> &what, const string &name, const vector<str
 
     if (!doesExist)
     {
+        findGenericSlots(toAdd);
         generics[name].push_back(toAdd);
     }
 
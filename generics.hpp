@@ -11,6 +11,8 @@ jdehmel@outlook.com
 #include <map>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "enums.hpp"
@@ -47,31 +49,83 @@ class generic_error : public runtime_error
     }
 };
 
+// A generic name within a template block: Its position in the
+// block, and its index in the generic names
+struct genericSlot
+{
+    unsigned int pos;
+    unsigned int index;
+};
+
 // Internal struct for info
 struct genericInfo
 {
-    vector<string> typeVec;
+    vector<token> typeVec;
     string originFile;
 
-    vector<string> symbols;
-    vector<string> preBlock, postBlock;
+    vector<token> symbols;
+    vector<token> preBlock, postBlock;
+
+    vector<token> genericNames;
 
-    vector<string> genericNames;
+    // Where the generic names fall in symbols, preBlock and
+    // postBlock, so instantiation need not look up every token
+    vector<genericSlot> symbolSlots, preSlots, postSlots;
 
-    vector<vector<vector<string>>> instances;
+    vector<vector<vector<token>>> instances;
 };
 
 // Avoid using this unless you absolutely must
 extern map<string, vector<genericInfo>> generics;
 
+// True if functions named in the post blocks of generics should
+// only be instantiated once something calls them (-L)
+extern bool lazyInstantiation;
+
+// A function instantiation deferred by -L
+struct pendingInstance
+{
+    vector<vector<token>> genericSubs;
+    vector<token> typeVec;
+};
+
+// Deferred instantiations by function name
+extern map<string, vector<pendingInstance>> pendingInstances;
+
+// The instances of one candidate, by packed substitutions.
+// Instances are only ever appended, so the first indexed of
+// them are known to be in keys.
+struct __instanceIndex
+{
+    size_t indexed = 0;
+    unordered_set<string> keys;
+};
+
+// Instance indices by template name and candidate index
+extern unordered_map<string, vector<__instanceIndex>> instanceIndices;
+
+// Mangled names by template name, type vector and
+// substitutions, for every instantiation which has succeeded.
+// Like instanceIndices, this describes the current generics
+// and table, so must be swapped out whenever they are.
+extern unordered_map<string, string> instantiations;
+
+// Instantiates everything pending under a function name. Must
+// be called before the candidates of a call are looked up.
+void instantiatePending(const string &name);
+
 // Can throw generic_error's if no viable options exist.
 // Ensure all items in genericSubs have been pre-mangled.
 // Returns the mangled version.
-string instantiateGeneric(const string &what, const vector<vector<string>> &genericSubs, const vector<string> &typeVec);
+string instantiateGeneric(const string &what, const vector<vector<token>> &genericSubs, const vector<token> &typeVec);
 
 // Also holds the skeleton of the inst block system, although gathering of these happens elsewhere.
-void addGeneric(const vector<string> &what, const string &name, const vector<string> &genericsList,
-                const vector<string> &typeVec, const vector<string> &preBlock, const vector<string> &postBlock);
+void addGeneric(const vector<token> &what, const string &name, const vector<token> &genericsList,
+                const vector<token> &typeVec, const vector<token> &preBlock, const vector<token> &postBlock);
+
+// Fills in the slots of a generic from its blocks and generic
+// names. Called by addGeneric.
+void findGenericSlots(genericInfo &info);
 
 // Print the info of all existing generics to a file stream
 void printGenericDumpInfo(ostream &to);
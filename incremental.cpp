@@ -0,0 +1,797 @@
+/*
+Jordan Dehmel
+jdehmel@outlook.com
+github.com/jorbDehmel
+2023 - present
+GPLv3 held by author
+*/
+
+#include "incremental.hpp"
+#include "acorn_resources.hpp"
+#include "enums.hpp"
+#include "generics.hpp"
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+bool incremental = false;
+
+#define FILE_STATE_MAGIC "oak file state 4"
+
+// These are reset by every file before they are read, and do not
+// change how the files included after them are translated. An
+// include which uses prev_file! is saved along with its includer.
+const static set<string> volatileDefines = {"comp_time!", "line!", "prev_file!"};
+
+/*
+The state is written as a flat binary blob: Numbers as eight
+raw bytes, strings as their length and then their bytes, and
+containers as their size and then their items. It is only ever
+read back by the same version of acorn on the same machine.
+*/
+
+class file_state_error : public runtime_error
+{
+  public:
+    file_state_error(const string &What) : runtime_error(What)
+    {
+    }
+};
+
+struct stateReader
+{
+    const string &data;
+    size_t pos;
+};
+
+static void put(string &Out, const unsigned long long &What)
+{
+    Out.append((const char *)&What, sizeof(What));
+    return;
+}
+
+static void put(string &Out, const bool &What)
+{
+    put(Out, (unsigned long long)What);
+    return;
+}
+
+static void put(string &Out, const string &What)
+{
+    put(Out, (unsigned long long)What.size());
+    Out.append(What);
+    return;
+}
+
+static void put(string &Out, const token &What)
+{
+    put(Out, What.str());
+    put(Out, (unsigned long long)What.line);
+    return;
+}
+
+static void put(string &Out, const Type &What)
+{
+    put(Out, (unsigned long long)What.size());
+    for (const auto &node : What.nodes())
+    {
+        put(Out, (unsigned long long)node.info);
+        put(Out, node.name);
+    }
+    return;
+}
+
+static void put(string &Out, const sequence &What);
+
+template <class T, class A> static void put(string &Out, const vector<T, A> &What);
+template <class T> static void put(string &Out, const map<string, T> &What);
+
+static void put(string &Out, const set<string> &What)
+{
+    put(Out, (unsigned long long)What.size());
+    for (const auto &item : What)
+    {
+        put(Out, item);
+    }
+    return;
+}
+
+static void put(string &Out, const sequence &What)
+{
+    put(Out, What.type);
+    put(Out, What.items);
+    put(Out, (unsigned long long)What.info);
+    put(Out, What.raw);
+    return;
+}
+
+static void put(string &Out, const __multiTableSymbol &What)
+{
+    put(Out, *What.seq);
+    put(Out, What.type);
+    put(Out, (unsigned long long)What.erased);
+    put(Out, What.sourceFilePath);
+    return;
+}
+
+static void put(string &Out, const __structLookupData &What)
+{
+    put(Out, What.members);
+    put(Out, What.order);
+    put(Out, (unsigned long long)What.erased);
+    return;
+}
+
+static void put(string &Out, const __enumLookupData &What)
+{
+    put(Out, What.options);
+    put(Out, What.order);
+    put(Out, (unsigned long long)What.erased);
+    return;
+}
+
+static void put(string &Out, const genericInfo &What)
+{
+    put(Out, What.typeVec);
+    put(Out, What.originFile);
+    put(Out, What.symbols);
+    put(Out, What.preBlock);
+    put(Out, What.postBlock);
+    put(Out, What.genericNames);
+    put(Out, What.instances);
+    return;
+}
+
+static void put(string &Out, const pendingInstance &What)
+{
+    put(Out, What.genericSubs);
+    put(Out, What.typeVec);
+    return;
+}
+
+static void put(string &Out, const rule &What)
+{
+    // Engines are saved by name
+    string engine = "";
+    for (const auto &p : engines)
+    {
+        if (p.second == What.doRule)
+        {
+            engine = p.first;
+            break;
+        }
+    }
+
+    if (engine == "")
+    {
+        throw file_state_error("Rule uses an unnamed engine.");
+    }
+
+    put(Out, What.inputPattern);
+    put(Out, What.outputPattern);
+    put(Out, engine);
+    return;
+}
+
+template <class T, class A> static void put(string &Out, const vector<T, A> &What)
+{
+    put(Out, (unsigned long long)What.size());
+    for (const auto &item : What)
+    {
+        put(Out, item);
+    }
+    return;
+}
+
+template <class T> static void put(string &Out, const map<string, T> &What)
+{
+    put(Out, (unsigned long long)What.size());
+    for (const auto &p : What)
+    {
+        put(Out, p.first);
+        put(Out, p.second);
+    }
+    return;
+}
+
+static void get(stateReader &In, unsigned long long &What)
+{
+    if (In.pos + sizeof(What) > In.data.size())
+    {
+        throw file_state_error("Truncated file state.");
+    }
+
+    memcpy(&What, In.data.data() + In.pos, sizeof(What));
+    In.pos += sizeof(What);
+    return;
+}
+
+static unsigned long long getNum(stateReader &In)
+{
+    unsigned long long out;
+    get(In, out);
+    return out;
+}
+
+static void get(stateReader &In, bool &What)
+{
+    What = getNum(In) != 0;
+    return;
+}
+
+static void get(stateReader &In, string &What)
+{
+    unsigned long long size = getNum(In);
+    if (In.pos + size > In.data.size())
+    {
+        throw file_state_error("Truncated file state.");
+    }
+
+    What.assign(In.data, In.pos, size);
+    In.pos += size;
+    return;
+}
+
+static void get(stateReader &In, token &What)
+{
+    string text;
+    get(In, text);
+    What = token(text);
+    What.line = getNum(In);
+    return;
+}
+
+static void get(stateReader &In, Type &What)
+{
+    vector<typeNode> nodes(getNum(In));
+    for (auto &node : nodes)
+    {
+        node.info = (TypeInfo)getNum(In);
+        get(In, node.name);
+    }
+
+    What = Type(nodes);
+    return;
+}
+
+static void get(stateReader &In, sequence &What);
+
+template <class T, class A> static void get(stateReader &In, vector<T, A> &What);
+template <class T> static void get(stateReader &In, map<string, T> &What);
+
+static void get(stateReader &In, set<string> &What)
+{
+    What.clear();
+    unsigned long long size = getNum(In);
+    for (unsigned long long i = 0; i < size; i++)
+    {
+        string item;
+        get(In, item);
+        What.insert(What.end(), item);
+    }
+    return;
+}
+
+static void get(stateReader &In, sequence &What)
+{
+    get(In, What.type);
+    get(In, What.items);
+    What.info = (sequenceInfo)getNum(In);
+    get(In, What.raw);
+    return;
+}
+
+static void get(stateReader &In, __multiTableSymbol &What)
+{
+    What.seq = newBody();
+    get(In, *What.seq);
+    get(In, What.type);
+    get(In, What.erased);
+    get(In, What.sourceFilePath);
+    return;
+}
+
+static void get(stateReader &In, __structLookupData &What)
+{
+    get(In, What.members);
+    get(In, What.order);
+    get(In, What.erased);
+    return;
+}
+
+static void get(stateReader &In, __enumLookupData &What)
+{
+    get(In, What.options);
+    get(In, What.order);
+    get(In, What.erased);
+    return;
+}
+
+static void get(stateReader &In, genericInfo &What)
+{
+    get(In, What.typeVec);
+    get(In, What.originFile);
+    get(In, What.symbols);
+    get(In, What.preBlock);
+    get(In, What.postBlock);
+    get(In, What.genericNames);
+    get(In, What.instances);
+    findGenericSlots(What);
+    return;
+}
+
+static void get(stateReader &In, pendingInstance &What)
+{
+    get(In, What.genericSubs);
+    get(In, What.typeVec);
+    return;
+}
+
+static void get(stateReader &In, rule &What)
+{
+    string engine;
+
+    get(In, What.inputPattern);
+    get(In, What.outputPattern);
+    get(In, engine);
+
+    if (engines.count(engine) == 0)
+    {
+        throw file_state_error("Unknown rule engine '" + engine + "'.");
+    }
+
+    What.doRule = engines[engine];
+    compileRule(What);
+    return;
+}
+
+template <class T, class A> static void get(stateReader &In, vector<T, A> &What)
+{
+    What.clear();
+    What.resize(getNum(In));
+    for (auto &item : What)
+    {
+        get(In, item);
+    }
+    return;
+}
+
+template <class T> static void get(stateReader &In, map<string, T> &What)
+{
+    What.clear();
+    unsigned long long size = getNum(In);
+    for (unsigned long long i = 0; i < size; i++)
+    {
+        string name;
+        get(In, name);
+        get(In, What.emplace_hint(What.end(), name, T())->second);
+    }
+    return;
+}
+
+/*
+Calls Fn on each part of the state doFile can change, bar the
+line symbols, which are only used in error messages. Maps and
+sets are saved entry by entry, and everything else whole.
+*/
+template <class F> static void forEachPart(F Fn)
+{
+    Fn(table);
+    Fn(structData);
+    Fn(structOrder);
+    Fn(enumData);
+    Fn(generics);
+    Fn(pendingInstances);
+    Fn(rules);
+    Fn(activeRules);
+    Fn(dialectRules);
+    Fn(dialectLock);
+    Fn(bundles);
+    Fn(visitedFiles);
+    Fn(loadedFiles);
+    Fn(cppSources);
+    Fn(objects);
+    Fn(cflags);
+    Fn(deps);
+    Fn(preprocDefines);
+    Fn(macros);
+    Fn(macroSourceFiles);
+    return;
+}
+
+template <class T> static unsigned long long hashOf(const T &What)
+{
+    string data;
+    put(data, What);
+    return hashBytes(data);
+}
+
+// Hashes each entry of Part into Out, and writes the hashes to
+// Key in order, leaving out the entries named in Skip
+template <class T>
+static void hashPart(const map<string, T> &Part, unordered_map<string, unsigned long long> &Out, string &Key,
+                     const set<string> &Skip)
+{
+    unsigned long long count = 0;
+    for (const auto &p : Part)
+    {
+        unsigned long long hash = hashOf(p.second);
+        Out[p.first] = hash;
+
+        if (Skip.count(p.first) == 0)
+        {
+            put(Key, p.first);
+            put(Key, hash);
+            count++;
+        }
+    }
+
+    put(Key, count);
+    return;
+}
+
+static void hashPart(const set<string> &Part, unordered_map<string, unsigned long long> &Out, string &Key,
+                     const set<string> &Skip)
+{
+    unsigned long long count = 0;
+    for (const auto &item : Part)
+    {
+        Out[item] = 0;
+
+        if (Skip.count(item) == 0)
+        {
+            put(Key, item);
+            count++;
+        }
+    }
+
+    put(Key, count);
+    return;
+}
+
+template <class T>
+static void hashPart(const T &Part, unordered_map<string, unsigned long long> &Out, string &Key, const set<string> &)
+{
+    unsigned long long hash = hashOf(Part);
+    Out[""] = hash;
+    put(Key, hash);
+    return;
+}
+
+// Writes the entries of Part which are new or differ from Base,
+// then the names of those which were removed
+template <class T>
+static void putDelta(string &Out, const map<string, T> &Part, const unordered_map<string, unsigned long long> &Base)
+{
+    string changed;
+    unsigned long long count = 0;
+
+    for (const auto &p : Part)
+    {
+        string entry;
+        put(entry, p.second);
+
+        auto found = Base.find(p.first);
+        if (found == Base.end() || found->second != hashBytes(entry))
+        {
+            put(changed, p.first);
+            changed.append(entry);
+            count++;
+        }
+    }
+
+    vector<string> removed;
+    for (const auto &p : Base)
+    {
+        if (Part.count(p.first) == 0)
+        {
+            removed.push_back(p.first);
+        }
+    }
+
+    put(Out, count);
+    Out.append(changed);
+    put(Out, removed);
+    return;
+}
+
+// Writes the items of Part which are not in Base, then those of
+// Base which are not in Part
+static void putDelta(string &Out, const set<string> &Part, const unordered_map<string, unsigned long long> &Base)
+{
+    set<string> added, removed;
+
+    for (const auto &item : Part)
+    {
+        if (Base.count(item) == 0)
+        {
+            added.insert(item);
+        }
+    }
+
+    for (const auto &p : Base)
+    {
+        if (Part.count(p.first) == 0)
+        {
+            removed.insert(p.first);
+        }
+    }
+
+    put(Out, added);
+    put(Out, removed);
+    return;
+}
+
+// Writes Part if it differs from Base
+template <class T>
+static void putDelta(string &Out, const T &Part, const unordered_map<string, unsigned long long> &Base)
+{
+    string data;
+    put(data, Part);
+
+    auto found = Base.find("");
+    if (found != Base.end() && found->second == hashBytes(data))
+    {
+        put(Out, false);
+    }
+    else
+    {
+        put(Out, true);
+        Out.append(data);
+    }
+
+    return;
+}
+
+// Reads what putDelta wrote, and adds to Apply a function which
+// applies it to Part
+template <class T>
+static void getDelta(stateReader &In, map<string, T> &Part, vector<std::function<void()>> &Apply)
+{
+    auto changed = make_shared<map<string, T>>();
+    auto removed = make_shared<vector<string>>();
+    get(In, *changed);
+    get(In, *removed);
+
+    Apply.push_back(
+        [&Part, changed, removed]()
+        {
+            for (const auto &name : *removed)
+            {
+                Part.erase(name);
+            }
+            for (auto &p : *changed)
+            {
+                swap(Part[p.first], p.second);
+            }
+        });
+
+    return;
+}
+
+static void getDelta(stateReader &In, set<string> &Part, vector<std::function<void()>> &Apply)
+{
+    auto added = make_shared<set<string>>();
+    auto removed = make_shared<set<string>>();
+    get(In, *added);
+    get(In, *removed);
+
+    Apply.push_back(
+        [&Part, added, removed]()
+        {
+            for (const auto &item : *removed)
+            {
+                Part.erase(item);
+            }
+            Part.insert(added->begin(), added->end());
+        });
+
+    return;
+}
+
+template <class T> static void getDelta(stateReader &In, T &Part, vector<std::function<void()>> &Apply)
+{
+    bool changed;
+    get(In, changed);
+
+    if (changed)
+    {
+        auto value = make_shared<T>();
+        get(In, *value);
+
+        Apply.push_back([&Part, value]() { swap(Part, *value); });
+    }
+
+    return;
+}
+
+// The file the state saved under Key is in
+static string getFileStatePath(const string &Key)
+{
+    return FILE_STATE_PATH + Key + ".state";
+}
+
+bool loadFileState(const string &From, const string &Key, const string &Includer)
+{
+    string path = getFileStatePath(Key);
+    ifstream file(path, ios::in | ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    stringstream contents;
+    contents << file.rdbuf();
+    file.close();
+
+    string data = contents.str();
+    stateReader in{data, 0};
+
+    map<string, string> fileHashes;
+
+    try
+    {
+        string magic, key, includer;
+        get(in, magic);
+        get(in, key);
+        get(in, includer);
+
+        if (magic != FILE_STATE_MAGIC || key != Key || (includer != "" && includer != Includer))
+        {
+            return false;
+        }
+
+        // Every file loaded must be unchanged, and must not have
+        // been skipped as the includer
+        get(in, fileHashes);
+
+        const string includerName = getRealName(Includer);
+        for (const auto &p : fileHashes)
+        {
+            string hash;
+            if (getRealName(p.first) == includerName || !hashFile(p.first, hash) || hash != p.second)
+            {
+                return false;
+            }
+        }
+
+        // Read everything before changing anything, so that a bad
+        // file leaves the current state as it was
+        vector<std::function<void()>> apply;
+        forEachPart([&](auto &Part) { getDelta(in, Part, apply); });
+
+        vector<token> newCurLineSymbols;
+        get(in, newCurLineSymbols);
+
+        for (auto &fn : apply)
+        {
+            fn();
+        }
+        swap(curLineSymbols, newCurLineSymbols);
+    }
+    catch (file_state_error &e)
+    {
+        return false;
+    }
+
+    // Mark it as used, for purgeFileStates
+    error_code error;
+    filesystem::last_write_time(path, filesystem::file_time_type::clock::now(), error);
+
+    // The time is the only thing which differs from a translation
+    preprocDefines["comp_time!"] = to_string(time(NULL));
+
+    return true;
+}
+
+fileStateBase getFileStateBase(const string &From, const string &Includer)
+{
+    fileStateBase out;
+    out.loadedFiles = loadedFiles;
+
+    // The key covers the state From is included into, but not the
+    // files which led to it, nor the includer's name
+    string key;
+    put(key, string(VERSION));
+    put(key, From);
+
+    const set<string> includerName = {getRealName(Includer)}, includerPath = {Includer}, none;
+
+    forEachPart(
+        [&](const auto &Part)
+        {
+            const void *part = &Part;
+            const set<string> &skip = part == &preprocDefines ? volatileDefines
+                                      : part == &visitedFiles ? includerName
+                                      : part == &loadedFiles  ? includerPath
+                                                              : none;
+
+            out.hashes.emplace_back();
+            hashPart(Part, out.hashes.back(), key, skip);
+        });
+
+    out.key = toHex(hashBytes(key));
+    return out;
+}
+
+void saveFileState(const string &From, const fileStateBase &Base, const string &Includer)
+{
+    map<string, string> fileHashes;
+    for (const auto &path : loadedFiles)
+    {
+        if (Base.loadedFiles.count(path) == 0)
+        {
+            string hash;
+            if (!hashFile(path, hash))
+            {
+                // Cannot be checked later, so is not saved
+                return;
+            }
+
+            fileHashes[path] = hash;
+        }
+    }
+
+    string data;
+    try
+    {
+        put(data, string(FILE_STATE_MAGIC));
+        put(data, Base.key);
+        put(data, Includer);
+        put(data, fileHashes);
+
+        size_t i = 0;
+        forEachPart([&](const auto &Part) { putDelta(data, Part, Base.hashes[i++]); });
+
+        put(data, curLineSymbols);
+    }
+    catch (file_state_error &e)
+    {
+        // Cannot be saved; It will simply be translated again
+        return;
+    }
+
+    filesystem::create_directories(FILE_STATE_PATH);
+
+    // Write then rename, so that an interrupted save is never read
+    string path = getFileStatePath(Base.key);
+    ofstream file(path + ".tmp", ios::out | ios::binary);
+    if (!file.is_open())
+    {
+        return;
+    }
+
+    file << data;
+    file.close();
+
+    filesystem::rename(path + ".tmp", path);
+
+    return;
+}
+
+void purgeFileStates(const unsigned long long &KB)
+{
+    vector<pair<filesystem::file_time_type, string>> states;
+
+    error_code error;
+    for (filesystem::directory_iterator it(FILE_STATE_PATH, error), end; !error && it != end; it.increment(error))
+    {
+        states.push_back({it->last_write_time(error), it->path().string()});
+    }
+
+    sort(states.begin(), states.end());
+
+    unsigned long long freed = 0;
+    for (const auto &p : states)
+    {
+        if (freed >= KB)
+        {
+            break;
+        }
+
+        freed += getSize(p.second);
+        filesystem::remove(p.second, error);
+    }
+
+    return;
+}
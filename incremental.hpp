@@ -0,0 +1,66 @@
+/*
+Jordan Dehmel
+jdehmel@outlook.com
+github.com/jorbDehmel
+2023 - present
+GPLv3 held by author
+
+Incremental translation (-I). When a file includes another,
+what the include adds to the front end's state (symbols,
+structs, enums, generics, rules, macros and preprocessor
+definitions) is saved in .oak_build/incremental. The next
+translation reloads it instead of translating the file again,
+so long as the include's inputs are unchanged: The state it
+was included into and the contents of every file it loaded.
+Each entry state gets its own saved file. The name of the file
+an include was included into is left out of that state unless
+the include uses it, so that entry points sharing a .oak_build
+share their saved std.
+
+Reloaded files do not run their c_sys! calls again.
+*/
+
+#ifndef INCREMENTAL_HPP
+#define INCREMENTAL_HPP
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+#define FILE_STATE_PATH ".oak_build/incremental/"
+
+// True if included files should be saved and reloaded (-I)
+extern bool incremental;
+
+// What an include's additions are measured against: The files
+// loaded before it, and the hashes of each part of the state.
+// The key it is saved under follows from these and its path.
+struct fileStateBase
+{
+    string key;
+    set<string> loadedFiles;
+    vector<unordered_map<string, unsigned long long>> hashes;
+};
+
+// If From was saved under Key and none of the files it loaded
+// have changed, applies what it added to the current state and
+// returns true. Includer is the file it is being included into.
+bool loadFileState(const string &From, const string &Key, const string &Includer);
+
+// Records the current state, just before From is included into
+// Includer
+fileStateBase getFileStateBase(const string &From, const string &Includer);
+
+// Saves what From added to the state since Base. Includer is the
+// file it was included into if the translation depended on its
+// name, and empty otherwise.
+void saveFileState(const string &From, const fileStateBase &Base, const string &Includer);
+
+// Removes the least recently used saved states until KB
+// kilobytes have been freed or none are left
+void purgeFileStates(const unsigned long long &KB);
+
+#endif
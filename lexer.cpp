@@ -7,704 +7,624 @@ GPLv3 held by author
 */
 
 #include "lexer.hpp"
+#include <deque>
 using namespace std;
 
-const string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
-const string numbers = "0123456789";
+/*
+lex() makes a single pass over the source. Each character is
+classified by table lookup, and runs of name characters are taken
+whole. Tokens are views of the source text, and are only copied
+when built from parts which are not adjacent in it (for instance
+a minus sign and the number after it, with a space in between).
+
+Decimals, negatives, hex literals and adjacent strings are merged
+as each token is emitted, by lexemeStream below, with one token of
+lookahead, rather than by a second pass over the output. Line
+markers are kept out of band throughout.
+*/
 
-vector<string> lex(const string &What)
+// The lexical classes of characters
+enum charClass : unsigned char
 {
-    vector<string> out;
-    string cur = "";
-    unsigned long long line = 1;
-
-    char c;
+    name_char = 0, // Part of a name or literal
+    space_char,    // Spaces and tabs
+    newline_char,  // \n
+    delim_char,    // ; ( ) [ ] { } . , @
+    operator_char, // - < > = & | : + * / % ^
+    bang_char,     // !, only after a space
+    quote_char,    // " and ', unless escaped
+    rule_char,     // $
+    preproc_char,  // #
+};
+
+// The class of every character
+static const charClass *getCharClasses()
+{
+    static charClass classes[256];
+    static bool made = false;
 
-    for (unsigned int i = 0; i < What.size(); i++)
+    if (!made)
     {
-        c = What[i];
-
-        // Universal deliminators ignored
-        // Ex: whitespace
-        if (c == ' ' || c == '\t' || c == '\n')
+        for (int i = 0; i < 256; i++)
         {
-            if (cur != "")
-            {
-                out.push_back(cur);
-                cur = "";
-            }
-
-            if (c == '\n')
-            {
-                // Newline. Increment line count and insert line special symbol
-                line++;
-                out.push_back("//__LINE__=" + to_string(line));
-            }
-
-            continue;
+            classes[i] = name_char;
         }
 
-        // Rule processing; Use whole word
-        else if (c == '$')
-        {
-            while (i < What.size() && What[i] != ' ' && What[i] != '\t')
-            {
-                cur += What[i];
-                i++;
-            }
-
-            out.push_back(cur);
-            cur = "";
+        classes[(unsigned char)' '] = classes[(unsigned char)'\t'] = space_char;
+        classes[(unsigned char)'\n'] = newline_char;
 
-            continue;
+        for (const char &c : string(";()[]{}.,@"))
+        {
+            classes[(unsigned char)c] = delim_char;
         }
-
-        // Preproc, should NOT get to this point!
-        else if (c == '#')
+        for (const char &c : string("-<>=&|:+*/%^"))
         {
-            // The whole line is garbage for our concerns
-            while (i < What.size() && What[i] != '\n')
-            {
-                i++;
-            }
-            continue;
+            classes[(unsigned char)c] = operator_char;
         }
 
-        // Single-line comments, also shouldn't get to this point
-        else if (c == '/' && i + 1 < What.size() && What[i + 1] == '/')
-        {
-            while (i < What.size() && What[i] != '\n')
-            {
-                i++;
-            }
+        classes[(unsigned char)'!'] = bang_char;
+        classes[(unsigned char)'"'] = classes[(unsigned char)'\''] = quote_char;
+        classes[(unsigned char)'$'] = rule_char;
+        classes[(unsigned char)'#'] = preproc_char;
 
-            line++;
-            out.push_back("//__LINE__=" + to_string(line));
+        made = true;
+    }
 
-            continue;
-        }
+    return classes;
+}
 
-        // Multi-line comments, ditto as above
-        else if (c == '/' && i + 1 < What.size() && What[i + 1] == '*')
-        {
-            int count = 0;
+static inline bool isDigit(const char &C)
+{
+    return '0' <= C && C <= '9';
+}
 
-            while (true)
-            {
-                if (i + 2 < What.size() && What.substr(i, 2) == "/*")
-                {
-                    count++;
-                }
-                else if (i + 2 < What.size() && What.substr(i, 2) == "*/")
-                {
-                    count--;
-                }
+static inline bool isHexDigit(const char &C)
+{
+    return isDigit(C) || ('a' <= C && C <= 'f') || ('A' <= C && C <= 'F');
+}
 
-                if (i + 1 >= What.size())
-                {
-                    break;
-                }
-                else if (count == 0 && What[i] == '*' && What[i + 1] == '/')
-                {
-                    break;
-                }
-                else
-                {
-                    if (What[i] == '\n')
-                    {
-                        line++;
-                        out.push_back("//__LINE__=" + to_string(line));
-                    }
+// A token's text, or a marker of the source line which follows
+struct lexeme
+{
+    string_view text;
+    unsigned long long line = 0;
+    bool isMarker = false;
+};
 
-                    i++;
-                }
-            }
-            i++;
-            continue;
-        }
+/*
+Receives tokens from lex() in order, merges those which form a
+single literal, and interns the results into Out. Each token
+waits in three stages: The last raw token, which a "]" may still
+be added to; The token being merged, which needs to see the next
+one; And the last merged token, which a "." or string literal may
+still be merged into.
+*/
+class lexemeStream
+{
+  public:
+    lexemeStream(vector<token> &Out) : out(Out)
+    {
+    }
 
-        // Conditional deliminators
-        // Ex: -> <= >= == != && ||
-        // -= += /= *= %= ^= &= |=
-        else if (c == '-')
+    // Emits a token. Empty ones are dropped.
+    void push(const string_view &What)
+    {
+        if (!What.empty())
         {
-            if (i + 1 >= What.size())
-            {
-                cur += c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else if (What[i + 1] != '>' && What[i + 1] != '=')
-            {
-                out.push_back(cur);
+            pushRaw(lexeme{What, 0, false});
+        }
 
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else
-            {
-                if (cur != "")
-                {
-                    out.push_back(cur);
-                }
+        return;
+    }
 
-                i++;
-                cur = c;
-                cur += What[i];
-                out.push_back(cur);
-                cur = "";
-            }
-            continue;
-        }
+    // Emits a marker that the following tokens are on Line
+    void pushLine(const unsigned long long &Line)
+    {
+        pushRaw(lexeme{string_view(), Line, true});
+        return;
+    }
 
-        else if (c == '<')
+    // Makes the last token "[]" if it was "[", returning true
+    bool closeBracket(const string_view &What)
+    {
+        if (hasRaw && !raw.isMarker && raw.text == "[")
         {
-            if (i + 1 >= What.size())
-            {
-                cur += c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else if (What[i + 1] != '=' && What[i + 1] != '<')
-            {
-                out.push_back(cur);
+            raw.text = join(raw.text, What);
+            return true;
+        }
 
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else
-            {
-                if (cur != "")
-                {
-                    out.push_back(cur);
-                }
+        return false;
+    }
 
-                i++;
-                cur = c;
+    // Emits everything which is still waiting
+    void finish()
+    {
+        if (hasRaw)
+        {
+            feed(raw);
+            hasRaw = false;
+        }
+        if (hasCur)
+        {
+            merge(nullptr);
+            hasCur = false;
+        }
+        if (hasResult)
+        {
+            emit(result);
+            hasResult = false;
+        }
 
-                // Nested templates fix
-                if (What[i] == '<' && i + 1 < What.size() && What[i + 1] != ' ')
-                {
-                    out.push_back(cur);
-                    cur = "";
-                }
+        return;
+    }
 
-                cur += What[i];
-                out.push_back(cur);
-                cur = "";
-            }
-            continue;
+    // Concatenates two pieces of text, only copying them if
+    // they are not adjacent in the source
+    string_view join(const string_view &A, const string_view &B)
+    {
+        if (A.empty())
+        {
+            return B;
         }
-
-        else if (c == '>')
+        else if (B.empty() || A.data() + A.size() == B.data())
         {
-            if (i + 1 >= What.size())
-            {
-                out.push_back(cur);
+            return string_view(A.data(), A.size() + B.size());
+        }
 
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else if (What[i + 1] != '=' && What[i + 1] != '>')
-            {
-                out.push_back(cur);
+        scratch.emplace_back(A);
+        scratch.back().append(B);
+        return scratch.back();
+    }
 
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else
-            {
-                if (cur != "")
-                {
-                    out.push_back(cur);
-                }
+    // Keeps a copy of What for as long as the stream exists
+    string_view keep(const string &What)
+    {
+        scratch.push_back(What);
+        return scratch.back();
+    }
 
-                i++;
-                cur = c;
+  protected:
+    void pushRaw(const lexeme &What)
+    {
+        if (hasRaw)
+        {
+            feed(raw);
+        }
 
-                // Nested templates fix
-                if (What[i] == '>' && i + 1 < What.size() && What[i + 1] != ' ')
-                {
-                    out.push_back(cur);
-                    cur = "";
-                }
+        raw = What;
+        hasRaw = true;
+        return;
+    }
 
-                cur += What[i];
-                out.push_back(cur);
-                cur = "";
-            }
-            continue;
+    void feed(const lexeme &Next)
+    {
+        if (!hasCur)
+        {
+            cur = Next;
+            hasCur = true;
         }
-
-        else if (c == '=')
+        else if (merge(&Next))
         {
-            if (i + 1 >= What.size())
-            {
-                cur += c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else if (What[i + 1] != '=')
-            {
-                out.push_back(cur);
+            hasCur = false;
+        }
+        else
+        {
+            cur = Next;
+        }
 
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else
-            {
-                if (cur != "")
-                {
-                    out.push_back(cur);
-                }
+        return;
+    }
 
-                i++;
-                cur = c;
-                cur += What[i];
-                out.push_back(cur);
-                cur = "";
-            }
-            continue;
-        }
+    // Merges cur with the tokens around it, if they form a single
+    // literal. Returns true if Next was used up.
+    bool merge(const lexeme *Next)
+    {
+        lexeme now = cur;
+        const lexeme *prev = (hasResult && !result.isMarker ? &result : nullptr);
+        const lexeme *next = (Next != nullptr && !Next->isMarker ? Next : nullptr);
+        bool usedPrev = false, usedNext = false;
 
-        // Boolean not (ignores the trailing ! on macros!)
-        else if (c == '!' && (i == 0 || What[i - 1] == ' '))
+        if (!now.isMarker && now.text == ".")
         {
-            if (i + 1 >= What.size())
+            // Decimals
+            if (prev != nullptr && (isDigit(prev->text[0]) ||
+                                    (prev->text != "-" && prev->text.size() > 1 && isDigit(prev->text[1]))))
             {
-                cur += c;
-                out.push_back(cur);
-                cur = "";
+                now.text = join(prev->text, now.text);
+                usedPrev = true;
             }
-            else if (What[i + 1] != '=')
-            {
-                out.push_back(cur);
 
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else
+            if (next != nullptr && isDigit(next->text[0]))
             {
-                if (cur != "")
-                {
-                    out.push_back(cur);
-                }
-
-                i++;
-                cur = c;
-                cur += What[i];
-                out.push_back(cur);
-                cur = "";
+                now.text = join(now.text, next->text);
+                usedNext = true;
             }
-            continue;
         }
-
-        else if (c == '&')
+        else if (!now.isMarker && now.text == "-")
         {
-            if (i + 1 >= What.size())
+            // Negatives
+            if (next != nullptr && isDigit(next->text[0]))
             {
-                cur += c;
-                out.push_back(cur);
-                cur = "";
+                now.text = join(now.text, next->text);
+                usedNext = true;
             }
-            else if (What[i + 1] != '&' && What[i + 1] != '=')
-            {
-                out.push_back(cur);
-
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else
+        }
+        else if (prev != nullptr && prev->text.back() == '"' && !now.isMarker && now.text.front() == '"')
+        {
+            // Adjacent strings
+            now.text = join(prev->text.substr(0, prev->text.size() - 1), now.text.substr(1));
+            usedPrev = true;
+        }
+        else if (prev != nullptr && prev->text.back() == '"' && now.isMarker && next != nullptr &&
+                 next->text.front() == '"')
+        {
+            // Strings on successive lines; The marker is lost
+            now = lexeme{join(prev->text.substr(0, prev->text.size() - 1), next->text.substr(1)), 0, false};
+            usedPrev = usedNext = true;
+        }
+        else if (!now.isMarker && (now.text == "0x" || now.text == "0b"))
+        {
+            // Spaced hex and binary literals
+            if (Next != nullptr)
             {
-                if (cur != "")
+                if (Next->isMarker)
+                {
+                    now.text = join(now.text, keep("//__LINE__=" + to_string(Next->line)));
+                }
+                else
                 {
-                    out.push_back(cur);
+                    now.text = join(now.text, Next->text);
                 }
 
-                i++;
-                cur = c;
-                cur += What[i];
-                out.push_back(cur);
-                cur = "";
+                usedNext = true;
             }
-            continue;
+        }
+        else if (!now.isMarker && isDigit(now.text.front()) && isHexDigit(now.text.back()) && next != nullptr &&
+                 isHexDigit(next->text.front()))
+        {
+            // Two successive numerical literals
+            now.text = join(now.text, next->text);
+            usedNext = true;
         }
 
-        else if (c == '|')
+        if (hasResult && !usedPrev)
         {
-            if (i + 1 >= What.size())
-            {
-                cur += c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else if (What[i + 1] != '|' && What[i + 1] != '=')
-            {
-                out.push_back(cur);
+            emit(result);
+        }
 
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            else
-            {
-                if (cur != "")
-                {
-                    out.push_back(cur);
-                }
+        result = now;
+        hasResult = true;
+        return usedNext;
+    }
 
-                i++;
-                cur = c;
-                cur += What[i];
-                out.push_back(cur);
-                cur = "";
-            }
-            continue;
+    // Interns a finished token, or moves to the line it marks
+    void emit(const lexeme &What)
+    {
+        if (What.isMarker)
+        {
+            line = What.line;
         }
-
-        else if (c == ':')
+        else
         {
-            if (cur != "")
-            {
-                out.push_back(cur);
-            }
+            out.push_back(token(What.text));
+            out.back().line = line;
+        }
 
-            cur = ":";
+        return;
+    }
 
-            if (i + 1 < What.size() && What[i + 1] == ':')
-            {
-                i++;
-                out.push_back("::");
-                cur = "";
-            }
-            else
-            {
-                out.push_back(":");
-                cur = "";
-            }
-            continue;
-        }
+    vector<token> &out;
+    unsigned long long line = 1;
+
+    lexeme raw, cur, result;
+    bool hasRaw = false, hasCur = false, hasResult = false;
+
+    // Text which is not a single view of the source
+    deque<string> scratch;
+};
+
+// Lexes the operator or comment at What[I], leaving I on its
+// last character
+static void lexOperator(const string_view &What, size_t &I, unsigned long long &Line, string_view &Cur,
+                        lexemeStream &Stream)
+{
+    const size_t size = What.size();
+    const char c = What[I];
+    const char next = (I + 1 < size ? What[I + 1] : '\0');
 
-        else if (c == '+')
+    switch (c)
+    {
+    // Conditional deliminators
+    // Ex: -> <= >= == != && ||
+    case '-':
+    case '=':
+    case '!':
+    case '&':
+    case '|':
+        if (I + 1 >= size)
         {
-            if (What.size() > i + 1 && What[i + 1] == '=')
-            {
-                cur += c;
-                cur += What[i + 1];
-                out.push_back(cur);
-                i++;
-                cur = "";
-            }
-            else if (What.size() > i + 1 && What[i + 1] == '+')
-            {
-                // Increment operator ++
-                cur += c;
-                cur += What[i + 1];
-                out.push_back(cur);
-                i++;
-                cur = "";
-            }
-            else
-            {
-                out.push_back(cur);
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            continue;
+            Stream.push(Stream.join(Cur, What.substr(I, 1)));
         }
-
-        else if (c == '-')
+        else if ((c == '-' && next == '>') || next == '=' || ((c == '&' || c == '|') && next == c))
         {
-            if (What.size() > i + 1 && (What[i + 1] == '=' || What[i + 1] == '-'))
-            {
-                cur += c;
-                cur += What[i + 1];
-                out.push_back(cur);
-                i++;
-                cur = "";
-            }
-            else
-            {
-                out.push_back(cur);
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            continue;
+            Stream.push(Cur);
+            Stream.push(What.substr(I, 2));
+            I++;
         }
-
-        else if (c == '*')
+        else
         {
-            if (What.size() > i + 1 && What[i + 1] == '=')
-            {
-                cur += c;
-                cur += What[i + 1];
-                out.push_back(cur);
-                i++;
-                cur = "";
-            }
-            else
-            {
-                out.push_back(cur);
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            continue;
+            Stream.push(Cur);
+            Stream.push(What.substr(I, 1));
         }
+        break;
 
-        else if (c == '/')
+    case '<':
+    case '>':
+        if (I + 1 >= size)
         {
-            if (What.size() > i + 1 && What[i + 1] == '=')
+            if (c == '<')
             {
-                cur += c;
-                cur += What[i + 1];
-                out.push_back(cur);
-                i++;
-                cur = "";
+                Stream.push(Stream.join(Cur, What.substr(I, 1)));
             }
             else
             {
-                out.push_back(cur);
-
-                cur = c;
-                out.push_back(cur);
-                cur = "";
+                Stream.push(Cur);
+                Stream.push(What.substr(I, 1));
             }
-            continue;
         }
-
-        else if (c == '%')
+        else if (next != '=' && next != c)
         {
-            if (What.size() > i + 1 && What[i + 1] == '=')
-            {
-                cur += c;
-                cur += What[i + 1];
-                out.push_back(cur);
-                i++;
-                cur = "";
-            }
-            else
-            {
-                out.push_back(cur);
-
-                cur = c;
-                out.push_back(cur);
-                cur = "";
-            }
-            continue;
+            Stream.push(Cur);
+            Stream.push(What.substr(I, 1));
         }
-
-        else if (c == '^')
+        else
         {
-            if (What.size() > i + 1 && What[i + 1] == '=')
+            Stream.push(Cur);
+            I++;
+
+            // Nested templates fix
+            if (next == c && I + 1 < size && What[I + 1] != ' ')
             {
-                cur += c;
-                cur += What[i + 1];
-                out.push_back(cur);
-                i++;
-                cur = "";
+                Stream.push(What.substr(I - 1, 1));
+                Stream.push(What.substr(I, 1));
             }
             else
             {
-                out.push_back(cur);
-                cur = c;
-                out.push_back(cur);
-                cur = "";
+                Stream.push(What.substr(I - 1, 2));
             }
-            continue;
         }
+        break;
 
-        // Universal deliminators (non-ignored)
-        else if (c == ';' || c == '(' || c == ')' || c == '[' || c == ']' || c == '{' || c == '}' || c == '.' ||
-                 c == ',' || c == '^' || c == '@')
+    case ':':
+        Stream.push(Cur);
+
+        if (next == ':')
         {
-            if (cur != "")
-            {
-                out.push_back(cur);
-            }
+            Stream.push(What.substr(I, 2));
+            I++;
+        }
+        else
+        {
+            Stream.push(What.substr(I, 1));
+        }
+        break;
 
-            if (c == ']' && !out.empty() && out.back() == "[")
-            {
-                out.back().push_back(']');
-            }
-            else
+    case '/':
+        // Single-line comments, also shouldn't get to this point
+        if (next == '/')
+        {
+            while (I < size && What[I] != '\n')
             {
-                cur = c;
-                out.push_back(cur);
-                cur = "";
+                I++;
             }
 
-            continue;
+            Line++;
+            Stream.pushLine(Line);
+            return;
         }
 
-        // String literals
-        else if ((i == 0 || What[i - 1] != '\\') && (c == '"' || c == '\''))
+        // Multi-line comments, ditto as above
+        else if (next == '*')
         {
-            if (cur != "")
-            {
-                out.push_back(cur);
-                cur = "";
-            }
+            int count = 0;
 
-            i++;
-            while (i < What.size() && What[i] != c)
+            while (true)
             {
-                if (What[i] == '\\')
+                if (I + 2 < size && What[I] == '/' && What[I + 1] == '*')
+                {
+                    count++;
+                }
+                else if (I + 2 < size && What[I] == '*' && What[I + 1] == '/')
+                {
+                    count--;
+                }
+
+                if (I + 1 >= size)
+                {
+                    break;
+                }
+                else if (count == 0 && What[I] == '*' && What[I + 1] == '/')
                 {
-                    cur += What[i];
-                    cur += What[i + 1];
-                    i += 2;
+                    break;
                 }
                 else
                 {
-                    cur += What[i];
-                    i++;
+                    if (What[I] == '\n')
+                    {
+                        Line++;
+                        Stream.pushLine(Line);
+                    }
+
+                    I++;
                 }
             }
 
-            out.push_back("\"" + cur + "\"");
-            cur = "";
-
-            continue;
+            I++;
+            return;
         }
 
-        // Character set change deliminator (number to letter only)
-        // else if (i + 1 < What.size() && numbers.find(c) != string::npos && alphabet.find(What[i + 1]) !=
-        // string::npos)
-        // {
-        //     cur += c;
-        //     out.push_back(cur);
-        //     cur = "";
-        //     continue;
-        // }
+        [[fallthrough]];
 
-        // Non-deliminators
+    // Compound assignments, which stay attached to the token
+    // before them, and ++
+    default:
+        if (next == '=' || (c == '+' && next == '+'))
+        {
+            Stream.push(Stream.join(Cur, What.substr(I, 2)));
+            I++;
+        }
         else
         {
-            cur += c;
+            Stream.push(Cur);
+            Stream.push(What.substr(I, 1));
         }
+        break;
     }
 
-    if (cur != "")
+    Cur = string_view();
+    return;
+}
+
+// Lexes the string literal starting at What[I], leaving I on its
+// closing quote. Character literals become string literals.
+static string_view lexString(const string_view &What, size_t &I, lexemeStream &Stream)
+{
+    const char quote = What[I];
+    const size_t start = I;
+
+    I++;
+    while (I < What.size() && What[I] != quote)
     {
-        out.push_back(cur);
-        cur = "";
+        // Escapes are kept as they are
+        I += (What[I] == '\\' ? 2 : 1);
     }
 
-    for (int i = 0; i < out.size(); i++)
+    if (quote == '"' && I < What.size())
     {
-        if (out[i] == "")
-        {
-            out.erase(out.begin() + i);
-            i--;
-        }
+        return What.substr(start, I + 1 - start);
     }
 
-    // Coagulation pass
-    string prev, next;
-    for (int i = 0; i < out.size(); i++)
+    string text = "\"";
+    text.append(What.substr(start + 1, min(I, What.size()) - start - 1));
+
+    // An escape at the very end takes the terminating null
+    if (I > What.size())
     {
-        prev = i == 0 ? "" : out[i - 1];
-        cur = out[i];
-        next = i + 1 == out.size() ? "" : out[i + 1];
+        text.push_back('\0');
+    }
 
-        if (cur == ".")
-        {
-            if (prev != "" && (('0' <= prev[0] && prev[0] <= '9') || (prev != "-" && '0' <= prev[1] && prev[1] <= '9')))
-            {
-                out[i] = prev + out[i];
-                out.erase(out.begin() + (i - 1));
-                i--;
+    text.push_back('"');
+    return Stream.keep(text);
+}
 
-                cur = out[i];
-                next = out[i + 1];
-            }
+vector<token> lex(const string_view &What)
+{
+    static const charClass *classes = getCharClasses();
 
-            if (next != "" && ('0' <= next[0] && next[0] <= '9'))
-            {
-                out[i] += next;
-                out.erase(out.begin() + (i + 1));
+    vector<token> out;
+    out.reserve(What.size() / 4);
 
-                cur = out[i];
-                next = out[i + 1];
-            }
-        }
-        else if (cur == "-")
+    lexemeStream stream(out);
+    string_view cur;
+    unsigned long long line = 1;
+    const size_t size = What.size();
+
+    for (size_t i = 0; i < size; i++)
+    {
+        const char c = What[i];
+
+        switch (classes[(unsigned char)c])
         {
-            if (next != "" && ('0' <= next[0] && next[0] <= '9'))
+        case name_char: {
+            size_t start = i;
+            while (i + 1 < size && classes[(unsigned char)What[i + 1]] == name_char)
             {
-                out[i] += next;
-                out.erase(out.begin() + (i + 1));
-
-                cur = out[i];
-                next = out[i + 1];
+                i++;
             }
+
+            cur = stream.join(cur, What.substr(start, i + 1 - start));
+            break;
         }
 
-        else if (prev.back() == '"' && cur.front() == '"')
-        {
-            prev.pop_back();
+        case space_char:
+        case newline_char:
+            stream.push(cur);
+            cur = string_view();
+
+            if (c == '\n')
+            {
+                // Newline. Increment line count and insert line marker
+                line++;
+                stream.pushLine(line);
+            }
+            break;
 
-            out[i] = prev + out[i].substr(1);
-            out.erase(out.begin() + (i - 1));
-            i--;
+        // Rule processing; Use whole word
+        case rule_char: {
+            size_t start = i;
+            while (i < size && What[i] != ' ' && What[i] != '\t')
+            {
+                i++;
+            }
 
-            cur = out[i];
-            next = out[i + 1];
+            stream.push(stream.join(cur, What.substr(start, i - start)));
+            cur = string_view();
+            break;
         }
 
-        else if (prev.back() == '"' && strncmp(cur.c_str(), "//", 2) == 0 && next.front() == '"')
-        {
-            prev.pop_back();
+        // Preproc, should NOT get to this point!
+        case preproc_char:
+            // The whole line is garbage for our concerns
+            while (i < size && What[i] != '\n')
+            {
+                i++;
+            }
+            break;
 
-            out[i] = prev + next.substr(1);
-            out.erase(out.begin() + (i - 1));
-            out.erase(out.begin() + i);
-            i--;
+        // Boolean not (ignores the trailing ! on macros!)
+        case bang_char:
+            if (i != 0 && What[i - 1] != ' ')
+            {
+                cur = stream.join(cur, What.substr(i, 1));
+                break;
+            }
 
-            cur = out[i];
-            next = out[i + 1];
-        }
+            [[fallthrough]];
 
-        else if (cur == "0x" || cur == "0b")
-        {
-            if (next != "")
+        case operator_char:
+            lexOperator(What, i, line, cur, stream);
+            break;
+
+        // Universal deliminators (non-ignored)
+        case delim_char:
+            stream.push(cur);
+            cur = string_view();
+
+            if (c != ']' || !stream.closeBracket(What.substr(i, 1)))
             {
-                out[i] += next;
-                out.erase(out.begin() + (i + 1));
+                stream.push(What.substr(i, 1));
+            }
+            break;
 
-                cur = out[i];
-                next = out[i + 1];
+        // String literals
+        case quote_char:
+            if (i != 0 && What[i - 1] == '\\')
+            {
+                cur = stream.join(cur, What.substr(i, 1));
+                break;
             }
-        }
 
-        // Two successive numerical literals; Merge
-        else if ((cur.size() >= 1 && '0' <= cur[0] && cur[0] <= '9') &&
-                 (('0' <= cur.back() && cur.back() <= '9') || ('a' <= cur.back() && cur.back() <= 'f') ||
-                  ('A' <= cur.back() && cur.back() <= 'F')) &&
-                 next != "" &&
-                 (('0' <= next.front() && next.front() <= '9') || ('a' <= next.front() && next.front() <= 'f') ||
-                  ('A' <= next.front() && next.front() <= 'F')))
-        {
-            out[i] += next;
-            out.erase(out.begin() + (i + 1));
+            stream.push(cur);
+            cur = string_view();
 
-            cur = out[i];
-            next = out[i + 1];
+            stream.push(lexString(What, i, stream));
+            break;
         }
-
-        prev = cur;
     }
 
+    stream.push(cur);
+    stream.finish();
+
     return out;
 }
 
@@ -18,14 +18,15 @@ Lexes files into tokens to be handled by the compiler.
 #include <vector>
 
 #include "tags.hpp"
+#include "tokens.hpp"
 
 using namespace std;
 
 // An assertion which throws a runtime error instead of breaking everything
 #define throw_assert(expression) ((bool)(expression) ? true : throw runtime_error("Assertion " #expression " failed."))
 
-// If an empty symbol is printed, it is a newline literal
-vector<string> lex(const string &What);
+// Each token records the source line it came from in its line member
+vector<token> lex(const string_view &What);
 
 // Throws an error upon failure
 void smartSystem(const string &What);
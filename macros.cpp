@@ -7,62 +7,374 @@ GPLv3 held by author
 */
 
 #include "macros.hpp"
+#include "acorn_resources.hpp"
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <iomanip>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+bool isMacroCall = false;
+
+// These are used by the compiler- Not literal macros
+static const set<string> compilerMacroNames = {
+    "include!", "link!",   "package!", "alloc!", "free!",  "free_arr!", "new_rule!", "use_rule!", "rem_rule!",
+    "bundle_rule!", "erase!", "c_print!", "c_panic!", "type!", "size!",   "ptrcpy!",   "ptrarr!",   "raw_c!"};
 
 // The pre-inserted ones are used by the compiler- Not literal macros
-set<string> compiled = {"include!",  "link!",     "package!",  "alloc!",       "free!",   "free_arr!",
-                        "new_rule!", "use_rule!", "rem_rule!", "bundle_rule!", "erase!",  "c_print!",
-                        "c_panic!",  "type!",     "size!",     "ptrcpy!",      "ptrarr!", "raw_c!"};
+set<string> compiled = compilerMacroNames;
 map<string, string> macros;
 map<string, string> macroSourceFiles;
 
 long long getAgeOfFile(const string &filepath)
 {
-    static map<string, long long> ageCache;
+    // Ages do not change under us during a run, except for the
+    // files we write ourselves
+    static unordered_map<string, long long> ageCache;
 
-    if (ageCache.count(filepath) != 0)
+    auto found = ageCache.find(filepath);
+    if (found != ageCache.end())
     {
-        return ageCache[filepath];
+        return found->second;
     }
 
-    smartSystem("mkdir -p .oak_build");
-    if (system(("stat -Lc %Y " + filepath + " > .oak_build/age_temp.txt 2> /dev/null").c_str()) != 0)
+    // Follows symlinks, as stat -L does
+    struct stat info;
+    if (stat(filepath.c_str(), &info) != 0)
     {
         return -1;
     }
 
-    ifstream file(".oak_build/age_temp.txt");
+    ageCache[filepath] = info.st_mtime;
+    return info.st_mtime;
+}
+
+// Returns true if the source file is newer than the destination one
+// OR if either file is nonexistant
+bool isSourceNewer(const string &source, const string &dest)
+{
+    long long sourceAge = getAgeOfFile(source);
+    long long destAge = getAgeOfFile(dest);
+
+    if (sourceAge == -1 || destAge == -1)
+    {
+        return true;
+    }
+
+    return (sourceAge > destAge);
+}
+
+unsigned long long hashBytes(const string &What, unsigned long long Hash)
+{
+    for (unsigned char c : What)
+    {
+        Hash ^= c;
+        Hash *= 1099511628211ULL;
+    }
+
+    return Hash;
+}
+
+string toHex(const unsigned long long &What)
+{
+    stringstream out;
+    out << hex << setw(16) << setfill('0') << What;
+    return out.str();
+}
+
+bool hashFile(const string &Path, string &Out)
+{
+    ifstream file(Path, ios::in | ios::binary);
     if (!file.is_open())
     {
-        return -1;
+        return false;
     }
 
-    long long out = -1;
-    file >> out;
+    stringstream contents;
+    contents << file.rdbuf();
+    Out = toHex(hashBytes(contents.str()));
 
-    file.close();
+    return true;
+}
 
-    if (ageCache.size() > 200)
+string getMacroCacheDir()
+{
+    const char *dir = getenv("OAK_MACRO_CACHE");
+    if (dir != nullptr)
     {
-        ageCache.clear();
+        return dir;
     }
-    ageCache[filepath] = out;
 
-    return out;
+    dir = getenv("XDG_CACHE_HOME");
+    if (dir != nullptr && dir[0] != '\0')
+    {
+        return string(dir) + "/oak/macros";
+    }
+
+    dir = getenv("HOME");
+    if (dir != nullptr && dir[0] != '\0')
+    {
+        return string(dir) + "/.cache/oak/macros";
+    }
+
+    return "";
 }
 
-// Returns true if the source file is newer than the destination one
-// OR if either file is nonexistant
-bool isSourceNewer(const string &source, const string &dest)
+/*
+Cache entries are two files, both moved into place by rename
+so that concurrent builds never see half of one. KEY.deps
+names the binary on its first line, then lists the hash and
+path of every file the binary was built from: The Oak the macro
+read, and the package objects it linked and their C. A lookup
+rehashes each of them. The binary is named by the key and a
+hash of that list, so a manifest can never be paired with a
+binary built from other sources.
+*/
+
+// Copies the cached binary for Key to BinPath if its sources
+// are unchanged. Returns true on a hit.
+static bool fetchCachedMacro(const string &Key, const string &BinPath)
 {
-    long long sourceAge = getAgeOfFile(source);
-    long long destAge = getAgeOfFile(dest);
+    string dir = getMacroCacheDir();
+    if (dir == "")
+    {
+        return false;
+    }
 
-    if (sourceAge == -1 || destAge == -1)
+    ifstream manifest(dir + "/" + Key + ".deps");
+    if (!manifest.is_open())
     {
-        return true;
+        return false;
     }
 
-    return (sourceAge > destAge);
+    string binName, hash, path, current;
+    getline(manifest, binName);
+
+    while (manifest >> hash && getline(manifest >> ws, path))
+    {
+        if (!hashFile(path, current) || current != hash)
+        {
+            return false;
+        }
+    }
+
+    error_code error;
+    string temp = BinPath + "." + to_string(getpid()) + ".tmp";
+
+    filesystem::copy_file(dir + "/" + binName, temp, filesystem::copy_options::overwrite_existing, error);
+    if (!error)
+    {
+        filesystem::permissions(temp, filesystem::perms::owner_all, filesystem::perm_options::add, error);
+    }
+    if (!error)
+    {
+        filesystem::rename(temp, BinPath, error);
+    }
+
+    if (error)
+    {
+        filesystem::remove(temp, error);
+        return false;
+    }
+
+    return true;
+}
+
+// Stores a freshly compiled macro binary. Failures are ignored;
+// The cache is only ever an optimization.
+static void storeCachedMacro(const string &Key, const string &BinPath, const set<string> &Sources)
+{
+    string dir = getMacroCacheDir();
+    if (dir == "")
+    {
+        return;
+    }
+
+    string deps;
+    for (const string &path : Sources)
+    {
+        string hash;
+        if (!hashFile(path, hash))
+        {
+            return;
+        }
+
+        deps += hash + " " + path + "\n";
+    }
+
+    string binName = Key + "-" + toHex(hashBytes(deps)) + ".out";
+    string temp = dir + "/." + Key + "." + to_string(getpid()) + ".tmp";
+
+    error_code error;
+    filesystem::create_directories(dir, error);
+    if (error)
+    {
+        return;
+    }
+
+    filesystem::copy_file(BinPath, temp, filesystem::copy_options::overwrite_existing, error);
+    if (!error)
+    {
+        filesystem::rename(temp, dir + "/" + binName, error);
+    }
+    if (error)
+    {
+        filesystem::remove(temp, error);
+        return;
+    }
+
+    ofstream manifest(temp);
+    if (!manifest.is_open())
+    {
+        return;
+    }
+
+    manifest << binName << '\n' << deps;
+    manifest.close();
+
+    filesystem::rename(temp, dir + "/" + Key + ".deps", error);
+    if (error)
+    {
+        filesystem::remove(temp, error);
+    }
+
+    return;
+}
+
+/*
+Translates and compiles a macro in this process, rather than
+through a second acorn. The translation starts from the same
+clean slate a fresh acorn would, and everything is put back
+afterwards; Only the loaded package info, the token pool, the
+files already lexed and the process itself carry over. So std
+and the other files the parent included are not read or lexed
+again, but they are sequenced again. This is deliberate: The
+parent's symbol table cannot seed the macro's, since
+reconstruction emits every symbol in the table, which would drag
+the parent's functions, links and main into the macro. Returns
+the files the binary was built from: The sources it read, and
+the objects it linked along with their C sources.
+*/
+static set<string> compileMacroInProcess(const string &SrcPath, const string &BinPath)
+{
+    multiSymbolTable oldTable;
+    map<string, vector<genericInfo>> oldGenerics;
+    unordered_map<string, vector<__instanceIndex>> oldInstanceIndices;
+    unordered_map<string, string> oldInstantiations;
+    map<string, vector<pendingInstance>> oldPendingInstances;
+    unordered_map<string, __overloadIndex> oldOverloadIndices;
+    map<string, __enumLookupData> oldEnumData;
+    map<string, __structLookupData> oldStructData;
+    vector<string> oldStructOrder;
+    set<string> oldDeps, oldVisitedFiles, oldLoadedFiles, oldCppSources, oldObjects, oldCflags,
+        oldCompiled = compilerMacroNames;
+    map<string, string> oldPreprocDefines, oldMacros, oldMacroSourceFiles;
+    map<string, rule> oldRules;
+    vector<string> oldActiveRules, oldDialectRules;
+    map<string, vector<string>> oldBundles;
+    bool oldDialectLock = false;
+
+    // Swap everything out for a fresh translation
+    auto swapState = [&]()
+    {
+        swap(table, oldTable);
+        swap(generics, oldGenerics);
+        swap(instanceIndices, oldInstanceIndices);
+        swap(instantiations, oldInstantiations);
+        swap(pendingInstances, oldPendingInstances);
+        swap(overloadIndices, oldOverloadIndices);
+        swap(enumData, oldEnumData);
+        swap(structData, oldStructData);
+        swap(structOrder, oldStructOrder);
+        swap(deps, oldDeps);
+        swap(visitedFiles, oldVisitedFiles);
+        swap(loadedFiles, oldLoadedFiles);
+        swap(cppSources, oldCppSources);
+        swap(objects, oldObjects);
+        swap(cflags, oldCflags);
+        swap(compiled, oldCompiled);
+        swap(preprocDefines, oldPreprocDefines);
+        swap(macros, oldMacros);
+        swap(macroSourceFiles, oldMacroSourceFiles);
+        swap(rules, oldRules);
+        swap(activeRules, oldActiveRules);
+        swap(dialectRules, oldDialectRules);
+        swap(bundles, oldBundles);
+        swap(dialectLock, oldDialectLock);
+        toStrCEnumCache.clear();
+        return;
+    };
+
+    string oldFile = curFile;
+    unsigned long long oldLine = curLine;
+    vector<token> oldLineSymbols = curLineSymbols;
+    bool oldIsMacroCall = isMacroCall;
+
+    swapState();
+    isMacroCall = true;
+
+    // The macro is a fresh top-level file, as it was under acorn -Mo
+    curFile = "";
+
+    // The objects the macro links, and the C they are rebuilt from
+    set<string> linkedFiles;
+
+    try
+    {
+        doFile(SrcPath);
+
+        if (table.count("main") == 0)
+        {
+            throw sequencing_error("A compilation unit must contain a main function.");
+        }
+
+        for (const string &object : objects)
+        {
+            if (filesystem::exists(object))
+            {
+                linkedFiles.insert(object);
+            }
+
+            if (object.size() >= 3 && object.substr(object.size() - 2) == ".o")
+            {
+                string source = object.substr(0, object.size() - 2) + ".c";
+                if (filesystem::exists(source))
+                {
+                    linkedFiles.insert(source);
+                }
+            }
+        }
+
+        pair<string, string> names = reconstructAndSave(BinPath);
+        cppSources.insert(names.second);
+
+        // Compile and link, as acorn -Mo would
+        compileSources();
+        linkObjects(BinPath);
+    }
+    catch (...)
+    {
+        swapState();
+        isMacroCall = oldIsMacroCall;
+        curFile = oldFile;
+        curLine = oldLine;
+        curLineSymbols = oldLineSymbols;
+        throw;
+    }
+
+    set<string> macroFiles = loadedFiles;
+    macroFiles.insert(linkedFiles.begin(), linkedFiles.end());
+
+    swapState();
+    isMacroCall = oldIsMacroCall;
+    curFile = oldFile;
+    curLine = oldLine;
+    curLineSymbols = oldLineSymbols;
+
+    return macroFiles;
 }
 
 void compileMacro(const string &Name, bool debug)
@@ -87,13 +399,27 @@ void compileMacro(const string &Name, bool debug)
     string srcPath = COMPILED_PATH + rootName + ".oak";
     string binPath = COMPILED_PATH + rootName + ".out";
 
-    // Check ages, makefile-style
-    if (!isSourceNewer(macroSourceFiles[Name], binPath))
+    // Look in the user-level cache, keyed by everything which
+    // goes into the binary besides the files it includes
+    string key = toHex(hashBytes(VERSION "\n" C_COMPILER "\n" LINKER "\n" MACRO_HOST_GREETING "\n" + macros[Name]));
+    if (fetchCachedMacro(key, binPath))
+    {
+        if (debug)
+        {
+            cout << "Using cached macro binary for '" << Name << "'\n";
+        }
+
+        compiled.insert(Name);
+        return;
+    }
+
+    // Without a cache, check ages, makefile-style
+    if (getMacroCacheDir() == "" && !isSourceNewer(macroSourceFiles[Name], binPath))
     {
         return;
     }
 
-    throw_assert(system("mkdir -p " COMPILED_PATH) == 0);
+    filesystem::create_directories(COMPILED_PATH);
 
     ofstream macroFile(srcPath);
     if (!macroFile.is_open())
@@ -105,13 +431,8 @@ void compileMacro(const string &Name, bool debug)
 
     macroFile.close();
 
-    // Call compiler
-    string command = COMPILER_COMMAND + (debug ? string(" -d") : string("")) + " -Mo " + binPath + " " + srcPath;
-
     if (debug)
     {
-        cout << "Compiling via command '" << command << "'\n";
-
         cout << tags::yellow_bold << "\n-----------------------------\n"
              << "Entering sub-file '" << srcPath << "'\n"
              << "-----------------------------\n"
@@ -119,9 +440,10 @@ void compileMacro(const string &Name, bool debug)
              << tags::reset << flush;
     }
 
+    set<string> sources;
     try
     {
-        throw_assert(system(command.c_str()) == 0);
+        sources = compileMacroInProcess(srcPath, binPath);
     }
     catch (runtime_error &e)
     {
@@ -146,18 +468,211 @@ void compileMacro(const string &Name, bool debug)
              << tags::reset << flush;
     }
 
+    // The macro's own source is covered by the key
+    sources.erase(srcPath);
+    storeCachedMacro(key, binPath, sources);
+
     compiled.insert(Name);
 
     return;
 }
 
-string callMacro(const string &Name, const vector<string> &Args, bool debug)
+// A compiled macro which stays running between calls
+struct macroServer
 {
-    if (compiled.count(Name) == 0)
+    pid_t pid;
+    int input;    // The write end of the macro's MACRO_FRAME_FD
+    FILE *output; // The read end of the macro's stdout
+};
+
+static map<string, macroServer> macroServers;
+
+// Macros which do not speak the host protocol
+static set<string> oneShotMacros;
+
+// Writes to a macro which has died should fail, not kill us.
+// A handler (rather than SIG_IGN) is not inherited over exec.
+static void ignoreSignal(int)
+{
+}
+
+static void stopMacroServer(macroServer &Server)
+{
+    close(Server.input);
+    fclose(Server.output);
+    waitpid(Server.pid, nullptr, 0);
+    return;
+}
+
+void stopMacroServers()
+{
+    for (auto &p : macroServers)
     {
-        compileMacro(Name, debug);
+        stopMacroServer(p.second);
+    }
+    macroServers.clear();
+
+    return;
+}
+
+// Starts a resident copy of a macro binary. Returns false if it
+// could not be started or does not answer the host greeting.
+static bool startMacroServer(const string &Name, const string &BinPath)
+{
+    static bool isSetUp = false;
+    if (!isSetUp)
+    {
+        signal(SIGPIPE, ignoreSignal);
+        atexit(stopMacroServers);
+        isSetUp = true;
+    }
+
+    // Close-on-exec, so that no other child holds these open
+    int toMacro[2], fromMacro[2];
+    if (pipe2(toMacro, O_CLOEXEC) != 0)
+    {
+        return false;
+    }
+    if (pipe2(fromMacro, O_CLOEXEC) != 0)
+    {
+        close(toMacro[0]);
+        close(toMacro[1]);
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(toMacro[0]);
+        close(toMacro[1]);
+        close(fromMacro[0]);
+        close(fromMacro[1]);
+        return false;
+    }
+    else if (pid == 0)
+    {
+        // Frames come in on their own fd, so that stdin is still
+        // ours; dup2 onto itself would keep close-on-exec
+        dup2(fromMacro[1], STDOUT_FILENO);
+        if (toMacro[0] == MACRO_FRAME_FD)
+        {
+            fcntl(MACRO_FRAME_FD, F_SETFD, 0);
+        }
+        else
+        {
+            dup2(toMacro[0], MACRO_FRAME_FD);
+        }
+        execl(BinPath.c_str(), BinPath.c_str(), MACRO_SERVER_FLAG, (char *)nullptr);
+        _exit(127);
     }
 
+    close(toMacro[0]);
+    close(fromMacro[1]);
+
+    macroServer server;
+    server.pid = pid;
+    server.input = toMacro[1];
+    server.output = fdopen(fromMacro[0], "r");
+
+    string greeting;
+    int c;
+    while ((c = getc(server.output)) != EOF && c != '\n')
+    {
+        greeting += (char)c;
+    }
+
+    if (greeting != MACRO_HOST_GREETING)
+    {
+        // An older host may be waiting on a stdin it shares with us
+        kill(pid, SIGKILL);
+        stopMacroServer(server);
+        return false;
+    }
+
+    macroServers[Name] = server;
+    return true;
+}
+
+// Undoes the quoting callMacroOnce gives an argument, as the
+// shell would, so that resident macros see the same argv
+static string shellUnquote(const string &Arg)
+{
+    string word;
+
+    if (Arg.front() != '"' || Arg.back() != '"')
+    {
+        word += '"';
+    }
+
+    for (size_t pos = 0; pos < Arg.size(); pos++)
+    {
+        if (Arg[pos] == '"' && pos != 0 && pos + 1 != Arg.size())
+        {
+            word += '\\';
+        }
+        word += Arg[pos];
+    }
+
+    if (Arg.front() != '"' || Arg.back() != '"')
+    {
+        word += '"';
+    }
+
+    string out;
+    bool inDouble = false, inSingle = false;
+    for (size_t i = 0; i < word.size(); i++)
+    {
+        char c = word[i];
+
+        if (inSingle)
+        {
+            if (c == '\'')
+            {
+                inSingle = false;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+        else if (c == '\\' && i + 1 < word.size())
+        {
+            char next = word[i + 1];
+
+            if (!inDouble || next == '"' || next == '\\' || next == '$' || next == '`')
+            {
+                out += next;
+                i++;
+            }
+            else if (next == '\n')
+            {
+                i++;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+        else if (c == '"')
+        {
+            inDouble = !inDouble;
+        }
+        else if (c == '\'' && !inDouble)
+        {
+            inSingle = true;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+
+    return out;
+}
+
+// Runs a macro binary once, through the shell
+static string callMacroOnce(const string &Name, const vector<string> &Args, bool debug)
+{
     string outputName = COMPILED_PATH + string("__oak_macro_out") + ".txt";
 
     string command = COMPILED_PATH + purifyStr(Name.substr(0, Name.size() - 1)) + ".out ";
@@ -175,7 +690,7 @@ string callMacro(const string &Name, const vector<string> &Args, bool debug)
             command += '"';
         }
 
-        int pos = 0;
+        size_t pos = 0;
         for (char c : s)
         {
             if (c == '"' && pos != 0 && pos + 1 != s.size())
@@ -234,6 +749,114 @@ string callMacro(const string &Name, const vector<string> &Args, bool debug)
 
     file.close();
 
+    return out;
+}
+
+string callMacro(const string &Name, const vector<string> &Args, bool debug)
+{
+    if (compiled.count(Name) == 0)
+    {
+        compileMacro(Name, debug);
+    }
+
+    string binPath = COMPILED_PATH + purifyStr(Name.substr(0, Name.size() - 1)) + ".out";
+
+    if (macroServers.count(Name) == 0 && (oneShotMacros.count(Name) != 0 || !startMacroServer(Name, binPath)))
+    {
+        oneShotMacros.insert(Name);
+
+        string out = callMacroOnce(Name, Args, debug);
+        if (debug)
+        {
+            cout << "Macro returned\n```\n" << out << "\n```\n";
+        }
+        return out;
+    }
+
+    macroServer &server = macroServers[Name];
+
+    // Frame: The argument count, then each argument's length
+    // and bytes. argv[0] is the binary, as for a normal run.
+    vector<string> argv = {binPath};
+    for (const string &s : Args)
+    {
+        if (s.size() != 0)
+        {
+            argv.push_back(shellUnquote(s));
+        }
+    }
+
+    string frame = to_string(argv.size()) + "\n";
+    for (const string &s : argv)
+    {
+        frame += to_string(s.size()) + "\n" + s;
+    }
+
+    if (debug)
+    {
+        cout << "Resident macro call `" << binPath;
+        for (size_t i = 1; i < argv.size(); i++)
+        {
+            cout << " '" << argv[i] << "'";
+        }
+        cout << "`\n";
+    }
+
+    for (size_t written = 0; written < frame.size();)
+    {
+        ssize_t result = write(server.input, frame.data() + written, frame.size() - written);
+        if (result <= 0)
+        {
+            break;
+        }
+        written += result;
+    }
+
+    // Everything up to the record separator is output
+    string out;
+    int c;
+    while ((c = getc(server.output)) != EOF && c != '\x1e')
+    {
+        out += (char)c;
+    }
+
+    int returnCode = 0;
+    if (c == EOF)
+    {
+        // The macro exited on its own; It is restarted next call
+        int status = 0;
+        close(server.input);
+        fclose(server.output);
+        waitpid(server.pid, &status, 0);
+        macroServers.erase(Name);
+
+        if (!WIFEXITED(status))
+        {
+            throw runtime_error("Macro system failure in resident macro '" + Name + "'");
+        }
+        returnCode = WEXITSTATUS(status);
+    }
+    else
+    {
+        string code;
+        while ((c = getc(server.output)) != EOF && c != '\n')
+        {
+            code += (char)c;
+        }
+        returnCode = atoi(code.c_str());
+    }
+
+    if (returnCode != 0)
+    {
+        throw runtime_error("Self-reported macro failure in resident macro '" + Name + "'");
+    }
+
+    // Match the line-by-line read of a one-shot call
+    if (!out.empty() && out.back() != '\n')
+    {
+        out += '\n';
+    }
+
     if (debug)
     {
         cout << "Macro returned\n```\n" << out << "\n```\n";
@@ -241,3 +864,71 @@ string callMacro(const string &Name, const vector<string> &Args, bool debug)
 
     return out;
 }
+
+string macroHostSource(const string &Arguments, const string &ReturnType)
+{
+    string call = MACRO_MAIN_NAME "(";
+    if (Arguments == "void")
+    {
+        call += ")";
+    }
+    else if (Arguments.find(',') == string::npos)
+    {
+        call += "argc)";
+    }
+    else
+    {
+        call += "argc, (void *)argv)";
+    }
+
+    string run = (ReturnType == "void") ? (call + ";\n        rc = 0;") : ("rc = (int)" + call + ";");
+
+    return "\n// Macro host; Runs the macro once per call frame on fd " + to_string(MACRO_FRAME_FD) +
+           "\n"
+           "#include <stdio.h>\n"
+           "#include <stdlib.h>\n"
+           "#include <string.h>\n"
+           "int main(int argc, char **argv)\n"
+           "{\n"
+           "    int rc = 0;\n"
+           "    if (argc != 2 || strcmp(argv[1], \"" MACRO_SERVER_FLAG "\") != 0)\n"
+           "    {\n"
+           "        " + run + "\n"
+           "        return rc;\n"
+           "    }\n"
+           "    FILE *frames = fdopen(" + to_string(MACRO_FRAME_FD) + ", \"r\");\n"
+           "    if (frames == NULL)\n"
+           "    {\n"
+           "        return 1;\n"
+           "    }\n"
+           "    fputs(\"" + string("\\x1e") + "oak macro host 2\\n\", stdout);\n"
+           "    fflush(stdout);\n"
+           "    while (fscanf(frames, \"%d\", &argc) == 1 && argc > 0)\n"
+           "    {\n"
+           "        argv = (char **)calloc(argc + 1, sizeof(char *));\n"
+           "        for (int i = 0; i < argc; i++)\n"
+           "        {\n"
+           "            size_t size = 0;\n"
+           "            if (fscanf(frames, \"%zu\", &size) != 1 || fgetc(frames) != '\\n')\n"
+           "            {\n"
+           "                return 1;\n"
+           "            }\n"
+           "            argv[i] = (char *)calloc(size + 1, 1);\n"
+           "            if (fread(argv[i], 1, size, frames) != size)\n"
+           "            {\n"
+           "                return 1;\n"
+           "            }\n"
+           "        }\n"
+           "        " + run + "\n"
+           "        fflush(stdout);\n"
+           "        printf(\"\\x1e%d\\n\", rc);\n"
+           "        fflush(stdout);\n"
+           "        for (int i = 0; i < argc; i++)\n"
+           "        {\n"
+           "            free(argv[i]);\n"
+           "        }\n"
+           "        free(argv);\n"
+           "    }\n"
+           "    return 0;\n"
+           "}\n";
+}
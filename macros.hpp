@@ -7,6 +7,21 @@ GPLv3 held by author
 
 Handles macro extraction, compilation, and replacement for Oak
 source code.
+
+A compiled macro is kept running for the rest of the
+translation: Its main is renamed, and a host main reads calls
+from MACRO_FRAME_FD and answers on stdout, ending each answer
+with a record separator and the return code. Stdin is left to
+the macro, as it was when each call was its own process. Binaries which do not
+answer the host greeting are run once per call, as they always
+were.
+
+Oak has no global variables, so a call cannot see what an
+earlier one did through the macro's own code. It can through
+C: Statics in linked C code and packages, heap memory the macro
+never frees, and open files or other process state all carry
+over from one call to the next. A macro which relies on these
+starting fresh must not use them.
 */
 
 #ifndef MACROS_HPP
@@ -17,6 +32,7 @@ source code.
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "reconstruct.hpp"
@@ -25,23 +41,57 @@ source code.
 using namespace std;
 
 #define COMPILED_PATH ".oak_build/"
-#define COMPILER_COMMAND "acorn"
+
+// The name main takes in a macro, and the argument which
+// starts the macro host instead of a single run
+#define MACRO_MAIN_NAME "__oak_macro_main"
+#define MACRO_SERVER_FLAG "--oak-macro-server"
+#define MACRO_HOST_GREETING "\x1eoak macro host 2"
+
+// The fd a macro host reads its call frames from
+#define MACRO_FRAME_FD 3
+
+// True if this translation is of a macro (-M)
+extern bool isMacroCall;
 
 extern set<string> compiled;
 extern map<string, string> macros;
 extern map<string, string> macroSourceFiles;
 
-// USES SYSTEM CALLS
+// USES SYSTEM CALLS; Macros are translated in-process, but
+// still compiled and run externally
 string callMacro(const string &Name, const vector<string> &Args, bool debug);
 void compileMacro(const string &Name, bool debug);
 
-// Misnomer: This returns the create time in seconds after epoch
-// Is costly the first time, but uses caching
+// The user-level cache of macro binaries, shared between
+// projects: $OAK_MACRO_CACHE, else $XDG_CACHE_HOME/oak/macros,
+// else ~/.cache/oak/macros. Empty if there is none; Setting
+// OAK_MACRO_CACHE to the empty string disables the cache.
+string getMacroCacheDir();
+
+// FNV-1a; Stable across runs and machines, unlike std::hash
+unsigned long long hashBytes(const string &What, unsigned long long Hash = 14695981039346656037ULL);
+
+// A hash as 16 hex digits
+string toHex(const unsigned long long &What);
+
+// Hashes the contents of a file into Out as hex. Returns false
+// if the file could not be read.
+bool hashFile(const string &Path, string &Out);
+
+// Stops all resident macros. Called automatically at exit.
+void stopMacroServers();
+
+// The C host main for a macro whose main has been renamed to
+// MACRO_MAIN_NAME, given the C arguments and return type
+string macroHostSource(const string &Arguments, const string &ReturnType);
+
+// Misnomer: This returns the modification time in seconds after
+// epoch, or -1 if the file does not exist. Cached for the run.
 long long getAgeOfFile(const string &filepath);
 
 // Returns true if the source file is newer than the destination one
 // OR if either file is nonexistant
-// Is costly the first time, but uses caching
 bool isSourceNewer(const string &source, const string &dest);
 
 #endif
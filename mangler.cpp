@@ -1,12 +1,44 @@
 #include "mangler.hpp"
+#include <unordered_map>
 
-string mangleStruct(const string &name, const vector<vector<string>> &generics)
+/*
+Each distinct type, token list or struct instantiation is
+mangled once per translation. The caches are keyed by the
+interned IDs of what was mangled, packed into a string.
+*/
+static unordered_map<string, string> mangleCache, mangleStructCache, mangleTypeCache;
+
+static void appendID(string &Key, const unsigned int &ID)
+{
+    Key.append((const char *)&ID, sizeof(ID));
+    return;
+}
+
+string mangleStruct(const string &name, const vector<vector<token>> &generics)
 {
     if (generics.size() == 0)
     {
         return name;
     }
 
+    string key = name;
+    for (const auto &raw : generics)
+    {
+        // Not an ID any token can have
+        appendID(key, -1);
+
+        for (const token &t : raw)
+        {
+            appendID(key, t.id);
+        }
+    }
+
+    auto found = mangleStructCache.find(key);
+    if (found != mangleStructCache.end())
+    {
+        return found->second;
+    }
+
     vector<string> outputParts;
     outputParts.push_back(name);
 
@@ -43,16 +75,31 @@ string mangleStruct(const string &name, const vector<vector<string>> &generics)
         }
     }
 
+    mangleStructCache[key] = out;
+
     return out;
 }
 
-string mangleEnum(const string &name, const vector<vector<string>> &generics)
+string mangleEnum(const string &name, const vector<vector<token>> &generics)
 {
     return mangleStruct(name, generics);
 }
 
 string mangleType(const Type &type)
 {
+    string key;
+    for (const auto &node : type.nodes())
+    {
+        appendID(key, node.info);
+        appendID(key, node.name.id);
+    }
+
+    auto found = mangleTypeCache.find(key);
+    if (found != mangleTypeCache.end())
+    {
+        return found->second;
+    }
+
     vector<string> outputParts;
 
     for (int i = 0; i < type.size(); i++)
@@ -96,6 +143,8 @@ string mangleType(const Type &type)
         }
     }
 
+    mangleTypeCache[key] = out;
+
     return out;
 }
 
@@ -117,13 +166,25 @@ string mangleSymb(const string &name, const string &typeStr)
     }
 }
 
-string mangle(const vector<string> &what)
+string mangle(const vector<token> &what)
 {
+    string key;
+    for (const token &t : what)
+    {
+        appendID(key, t.id);
+    }
+
+    auto found = mangleCache.find(key);
+    if (found != mangleCache.end())
+    {
+        return found->second;
+    }
+
     vector<string> outputParts;
 
-    for (auto s : what)
+    for (const token &s : what)
     {
-        if (s == "^")
+        if (s == tok::caret)
         {
             outputParts.push_back("PTR");
         }
@@ -140,31 +201,31 @@ string mangle(const vector<string> &what)
         {
             ;
         }
-        else if (s == ",")
+        else if (s == tok::comma)
         {
             outputParts.push_back("JOIN");
         }
-        else if (s == "(")
+        else if (s == tok::lparen)
         {
             outputParts.push_back("FN");
         }
-        else if (s == ")")
+        else if (s == tok::rparen)
         {
             ;
         }
-        else if (s == "->")
+        else if (s == tok::arrow)
         {
             outputParts.push_back("MAPS");
         }
-        else if (s == ":")
+        else if (s == tok::colon)
         {
             outputParts.push_back("TYPE");
         }
-        else if (s == "<")
+        else if (s == tok::langle)
         {
             outputParts.push_back("GEN");
         }
-        else if (s == ">")
+        else if (s == tok::rangle)
         {
             outputParts.push_back("ENDGEN");
         }
@@ -185,5 +246,7 @@ string mangle(const vector<string> &what)
         }
     }
 
+    mangleCache[key] = out;
+
     return out;
 }
@@ -8,19 +8,20 @@ Mangles symbol names and types into unambiguous C names.
 #ifndef MANGLER_HPP
 #define MANGLER_HPP
 
+#include "tokens.hpp"
 #include "type_builder.hpp"
 #include <string>
 #include <vector>
 using namespace std;
 
 // Used for mangling and resolving generics pre-sequencing
-string mangle(const vector<string> &what);
+string mangle(const vector<token> &what);
 
 // Mangle a struct, given its generic substitutions
-string mangleStruct(const string &name, const vector<vector<string>> &generics = vector<vector<string>>());
+string mangleStruct(const string &name, const vector<vector<token>> &generics = vector<vector<token>>());
 
 // Mangle an enumeration, givne its generic substitutions
-string mangleEnum(const string &name, const vector<vector<string>> &generics = vector<vector<string>>());
+string mangleEnum(const string &name, const vector<vector<token>> &generics = vector<vector<token>>());
 
 // Used for translation-time variable uniqueness in the face
 // of overloaded names. Not immediately useful, but necessary
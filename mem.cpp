@@ -17,7 +17,7 @@ sequence getAllocSequence(Type &type, const string &name, const string &num)
     // name = (type *)malloc(len * sizeof(type));
 
     out.items.push_back(
-        sequence{nullType, vector<sequence>(), atom,
+        sequence{nullType, {}, atom,
                  name + " = (" + toStrC(&type) + " *)malloc(sizeof(" + toStrC(&type) + ") * " + num + ")"});
 
     return out;
@@ -30,7 +30,7 @@ sequence getFreeSequence(const string &name, const bool &isArr)
     out.type = nullType;
     out.items.clear();
 
-    out.items.push_back(sequence{nullType, vector<sequence>(), atom, "free(" + name + ")"});
+    out.items.push_back(sequence{nullType, {}, atom, "free(" + name + ")"});
 
     return out;
 }
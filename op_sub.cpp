@@ -21,7 +21,7 @@ const static set<string> operators = {
 // Moves pre and post to include the operands to a binary
 // operator
 // Assumes that pre = i - 1, post = i + 1, i = index of bin op
-void getOperands(vector<string> &from, int &pre, int &post, const bool &useLine = false)
+void getOperands(tokenBuffer &from, size_t &pre, size_t &post, const bool &useLine = false)
 {
     /*
     Example cases:
@@ -36,9 +36,9 @@ void getOperands(vector<string> &from, int &pre, int &post, const bool &useLine
     // Decrement pre to point to the beginning of the left
     // operand
     count = 0;
-    do
+    while (true)
     {
-        if (from[pre] == "(")
+        if (from[pre] == tok::lparen)
         {
             count++;
 
@@ -49,7 +49,7 @@ void getOperands(vector<string> &from, int &pre, int &post, const bool &useLine
                     // Is function call
                     pre--;
                 }
-                else if (from[pre - 1] == ">")
+                else if (from[pre - 1] == tok::rangle)
                 {
                     // Possible templated function call
 
@@ -57,15 +57,15 @@ void getOperands(vector<string> &from, int &pre, int &post, const bool &useLine
                     // Else, not templating.
 
                     bool isTemplating = false;
-                    int i = pre - 2;
+                    int i = (int)pre - 2;
                     while (i >= 0)
                     {
-                        if (from[i] == ")" || from[i] == ";")
+                        if (from[i] == tok::rparen || from[i] == tok::semicolon)
                         {
                             isTemplating = false;
                             break;
                         }
-                        else if (from[i] == "<")
+                        else if (from[i] == tok::langle)
                         {
                             isTemplating = true;
                             break;
@@ -81,21 +81,26 @@ void getOperands(vector<string> &from, int &pre, int &post, const bool &useLine
                 }
             }
         }
-        else if (from[pre] == ")")
+        else if (from[pre] == tok::rparen)
         {
             count--;
         }
 
+        // Index 0 is only ever looked at first
+        if (pre <= 1 || count == 0)
+        {
+            break;
+        }
+
         pre--;
-    } while (pre > 0 && count != 0);
-    pre++;
+    }
 
     // Handle member access, refs and dereferences
-    while (pre >= 2 && from[pre - 1] == ".")
+    while (pre >= 2 && from[pre - 1] == tok::dot)
     {
         pre -= 2;
     }
-    while (pre > 0 && (from[pre - 1] == "^" || from[pre - 1] == "@"))
+    while (pre > 0 && (from[pre - 1] == tok::caret || from[pre - 1] == tok::at))
     {
         pre--;
     }
@@ -104,7 +109,7 @@ void getOperands(vector<string> &from, int &pre, int &post, const bool &useLine
     // If useLine, increment until a semicolon.
     if (useLine)
     {
-        while (post < from.size() && from[post] != ";")
+        while (post < from.size() && from[post] != tok::semicolon)
         {
             post++;
         }
@@ -114,24 +119,24 @@ void getOperands(vector<string> &from, int &pre, int &post, const bool &useLine
         count = 0;
         do
         {
-            if (from[post] == "(")
+            if (from[post] == tok::lparen)
             {
                 count++;
             }
-            else if (from[post] == ")")
+            else if (from[post] == tok::rparen)
             {
                 count--;
             }
 
-            while (post < from.size() && (from[post] == "^" || from[post] == "@"))
+            while (post < from.size() && (from[post] == tok::caret || from[post] == tok::at))
             {
                 post++;
             }
 
-            if (count == 0)
+            if (count == 0 && post + 1 < from.size())
             {
                 // Function call
-                if (operators.count(from[post]) == 0 && from[post + 1] == "(")
+                if (operators.count(from[post]) == 0 && from[post + 1] == tok::lparen)
                 {
                     post++;
                     count = 1;
@@ -142,7 +147,7 @@ void getOperands(vector<string> &from, int &pre, int &post, const bool &useLine
         } while (post < from.size() && count != 0);
 
         // Member access, references and dereferences
-        while (post + 2 < from.size() && from[post] == ".")
+        while (post + 2 < from.size() && from[post] == tok::dot)
         {
             post += 2;
         }
@@ -152,11 +157,11 @@ void getOperands(vector<string> &from, int &pre, int &post, const bool &useLine
 }
 
 // Substitute a single operation as identified
-void doSub(vector<string> &from, int &pos, const string &name)
+void doSub(tokenBuffer &from, size_t &pos, const string &name)
 {
-    int pre = pos - 1, post = pos + 1;
+    size_t pre = pos - 1, post = pos + 1;
     bool fullLine = false;
-    vector<string> toAdd;
+    vector<token> toAdd;
 
     if (name == "Copy" || (name != "Eq" && name.find("Eq") != string::npos))
     {
@@ -169,15 +174,15 @@ void doSub(vector<string> &from, int &pos, const string &name)
     // Reconstruct into valid output
     toAdd.reserve(post - pre + 2);
 
-    int start = pre, end = pos;
-    while (from[start] == "(" && from[end - 1] == ")")
+    size_t start = pre, end = pos;
+    while (from[start] == tok::lparen && from[end - 1] == tok::rparen)
     {
         start++;
         end--;
     }
 
     toAdd = {name, "("};
-    for (int i = start; i < end; i++)
+    for (size_t i = start; i < end; i++)
     {
         toAdd.push_back(from[i]);
     }
@@ -186,98 +191,96 @@ void doSub(vector<string> &from, int &pos, const string &name)
 
     start = pos + 1;
     end = post;
-    while (from[start] == "(" && from[end - 1] == ")")
+    while (from[start] == tok::lparen && from[end - 1] == tok::rparen)
     {
         start++;
         end--;
     }
 
-    for (int i = start; i < end; i++)
+    for (size_t i = start; i < end; i++)
     {
         toAdd.push_back(from[i]);
     }
     toAdd.push_back(")");
 
-    // Erase old (all items pre <= i < post)
-    for (int i = pre; i < post; i++)
-    {
-        from.erase(from.begin() + pre);
-    }
-
-    // Insert new
-    for (int j = toAdd.size() - 1; j >= 0; j--)
+    // Erase old (all items pre <= i < post), then insert new
+    if (post > pre)
     {
-        from.insert(from.begin() + pre, toAdd[j]);
+        from.erase(pre, post - pre);
     }
+    from.insert(pre, toAdd);
 
     pos--;
     return;
 }
 
-void operatorSub(vector<string> &From)
+// The original substitution: One pass over the whole stream per
+// level. Handles every case, including the ones the single-pass
+// rewriter below leaves alone.
+static void substituteByLevel(tokenBuffer &From)
 {
     // Level 2: Multiplication, division and modulo
-    for (int i = 0; i < From.size(); i++)
+    for (size_t i = 0; i < From.size(); i++)
     {
-        string cur = From[i];
+        const token &cur = From[i];
 
-        if (cur == "*")
+        if (cur == tok::star)
         {
             doSub(From, i, "Mult");
         }
-        else if (cur == "/")
+        else if (cur == tok::slash)
         {
             doSub(From, i, "Div");
         }
-        else if (cur == "%")
+        else if (cur == tok::percent)
         {
             doSub(From, i, "Mod");
         }
     }
 
     // Level 3: Addition and subtraction
-    for (int i = 0; i < From.size(); i++)
+    for (size_t i = 0; i < From.size(); i++)
     {
-        string cur = From[i];
-        if (cur == "+")
+        const token &cur = From[i];
+        if (cur == tok::plus)
         {
             doSub(From, i, "Add");
         }
-        else if (cur == "-")
+        else if (cur == tok::minus)
         {
             doSub(From, i, "Sub");
         }
     }
 
     // Level 4: Bitwise
-    for (int i = 0; i < From.size(); i++)
+    for (size_t i = 0; i < From.size(); i++)
     {
-        string cur = From[i];
+        const token &cur = From[i];
 
-        if (cur == "<<")
+        if (cur == tok::lshift)
         {
             doSub(From, i, "Lbs");
         }
-        else if (cur == ">>")
+        else if (cur == tok::rshift)
         {
             doSub(From, i, "Rbs");
         }
-        else if (cur == "&")
+        else if (cur == tok::amp)
         {
             doSub(From, i, "And");
         }
-        else if (cur == "|")
+        else if (cur == tok::pipe)
         {
             doSub(From, i, "Or");
         }
     }
 
     // Level 5: Comparisons
-    for (int i = 0; i < From.size(); i++)
+    for (size_t i = 0; i < From.size(); i++)
     {
-        string cur = From[i];
+        const token &cur = From[i];
 
-        if (cur == "<")
+        if (cur == tok::langle)
         {
             /*
             If a ) or ; occurs before the next >, do sub.
@@ -285,16 +288,16 @@ void operatorSub(vector<string> &From)
             */
 
             bool isTemplating = false;
-            int j = i + 1;
+            size_t j = i + 1;
             int depth = 1;
             for (; j < From.size(); j++)
             {
-                if (From[j] == ";" || From[j] == ")")
+                if (From[j] == tok::semicolon || From[j] == tok::rparen)
                 {
                     isTemplating = false;
                     break;
                 }
-                else if (From[j] == ">")
+                else if (From[j] == tok::rangle)
                 {
                     depth--;
 
@@ -304,7 +307,7 @@ void operatorSub(vector<string> &From)
                         break;
                     }
                 }
-                else if (From[j] == "<")
+                else if (From[j] == tok::langle)
                 {
                     depth++;
                 }
@@ -319,78 +322,78 @@ void operatorSub(vector<string> &From)
                 doSub(From, i, "Less");
             }
         }
-        else if (cur == ">")
+        else if (cur == tok::rangle)
         {
             doSub(From, i, "Great");
         }
 
-        else if (cur == "<=")
+        else if (cur == tok::less_eq)
         {
             doSub(From, i, "Leq");
         }
-        else if (cur == ">=")
+        else if (cur == tok::greater_eq)
         {
             doSub(From, i, "Greq");
         }
-        else if (cur == "==")
+        else if (cur == tok::equal)
         {
             doSub(From, i, "Eq");
         }
-        else if (cur == "!=")
+        else if (cur == tok::not_equal)
         {
             doSub(From, i, "Neq");
         }
     }
 
     // Level 6: Booleans
-    for (int i = 0; i < From.size(); i++)
+    for (size_t i = 0; i < From.size(); i++)
     {
-        string cur = From[i];
+        const token &cur = From[i];
 
-        if (cur == "&&")
+        if (cur == tok::amp_amp)
         {
             doSub(From, i, "Andd");
         }
-        else if (cur == "||")
+        else if (cur == tok::pipe_pipe)
         {
             doSub(From, i, "Orr");
         }
     }
 
     // Level 1: Assignment
-    for (int i = 0; i < From.size(); i++)
+    for (size_t i = 0; i < From.size(); i++)
     {
-        string cur = From[i];
+        const token &cur = From[i];
 
-        if (cur == "=")
+        if (cur == tok::assign)
         {
             doSub(From, i, "Copy");
         }
-        else if (cur == "+=")
+        else if (cur == tok::plus_eq)
         {
             doSub(From, i, "AddEq");
         }
-        else if (cur == "-=")
+        else if (cur == tok::minus_eq)
         {
             doSub(From, i, "SubEq");
         }
-        else if (cur == "*=")
+        else if (cur == tok::star_eq)
         {
             doSub(From, i, "MultEq");
         }
-        else if (cur == "/=")
+        else if (cur == tok::slash_eq)
         {
             doSub(From, i, "DivEq");
         }
-        else if (cur == "%=")
+        else if (cur == tok::percent_eq)
         {
             doSub(From, i, "ModEq");
         }
-        else if (cur == "&=")
+        else if (cur == tok::amp_eq)
         {
             doSub(From, i, "AndEq");
         }
-        else if (cur == "|=")
+        else if (cur == tok::pipe_eq)
         {
             doSub(From, i, "OrEq");
         }
@@ -398,3 +401,646 @@ void operatorSub(vector<string> &From)
 
     return;
 }
+
+/*
+Single-pass substitution
+
+No operand reaches past a semicolon, so each statement can be
+rewritten on its own. Most statements are rewritten by precedence
+climbing in one left-to-right walk, which yields the same tokens
+as the passes above. A statement that those passes treat in some
+unusual way (templates, unary operators, method calls, nested
+assignments and so on) is instead handed to substituteByLevel by
+itself, which costs only that statement's length.
+*/
+
+// Binding powers: Higher binds tighter
+enum bindingPower
+{
+    no_power = 0,
+    assign_power,  // Level 1: Takes the rest of the statement
+    bool_power,    // Level 6
+    compare_power, // Level 5
+    bitwise_power, // Level 4
+    add_power,     // Level 3
+    mult_power,    // Level 2
+};
+
+struct binaryOp
+{
+    token name;
+    int power = no_power;
+};
+
+// Returns the operator What is, or nullptr if it is not binary
+static const binaryOp *getBinaryOp(const token &What)
+{
+    static vector<binaryOp> table;
+
+    if (table.empty())
+    {
+        table.resize(tok::fixed_token_count);
+
+        table[tok::star] = {"Mult", mult_power};
+        table[tok::slash] = {"Div", mult_power};
+        table[tok::percent] = {"Mod", mult_power};
+
+        table[tok::plus] = {"Add", add_power};
+        table[tok::minus] = {"Sub", add_power};
+
+        table[tok::lshift] = {"Lbs", bitwise_power};
+        table[tok::rshift] = {"Rbs", bitwise_power};
+        table[tok::amp] = {"And", bitwise_power};
+        table[tok::pipe] = {"Or", bitwise_power};
+
+        table[tok::langle] = {"Less", compare_power};
+        table[tok::rangle] = {"Great", compare_power};
+        table[tok::less_eq] = {"Leq", compare_power};
+        table[tok::greater_eq] = {"Greq", compare_power};
+        table[tok::equal] = {"Eq", compare_power};
+        table[tok::not_equal] = {"Neq", compare_power};
+
+        table[tok::amp_amp] = {"Andd", bool_power};
+        table[tok::pipe_pipe] = {"Orr", bool_power};
+
+        table[tok::assign] = {"Copy", assign_power};
+        table[tok::plus_eq] = {"AddEq", assign_power};
+        table[tok::minus_eq] = {"SubEq", assign_power};
+        table[tok::star_eq] = {"MultEq", assign_power};
+        table[tok::slash_eq] = {"DivEq", assign_power};
+        table[tok::percent_eq] = {"ModEq", assign_power};
+        table[tok::amp_eq] = {"AndEq", assign_power};
+        table[tok::pipe_eq] = {"OrEq", assign_power};
+    }
+
+    if (What.id >= tok::fixed_token_count || table[What.id].power == no_power)
+    {
+        return nullptr;
+    }
+    return &table[What.id];
+}
+
+// True if What is in operators
+static bool isOperator(const token &What)
+{
+    return What == tok::comma || What == tok::lparen || What == tok::rparen || What == tok::semicolon ||
+           getBinaryOp(What) != nullptr;
+}
+
+// True if What can stand alone as an operand, or name a call
+static bool isAtom(const token &What)
+{
+    return What != tok::dot && What != tok::caret && What != tok::at && !isOperator(What);
+}
+
+// True if an operand can begin with What
+static bool beginsOperand(const token &What)
+{
+    return What == tok::lparen || What == tok::caret || What == tok::at || isAtom(What);
+}
+
+// If From[Begin] opens template brackets which substituteByLevel
+// skips, sets End to the bracket closing them and returns true
+static bool findTemplateEnd(const vector<token> &From, const size_t &Begin, size_t &End)
+{
+    int depth = 0;
+    for (size_t i = Begin; i < From.size(); i++)
+    {
+        if (From[i] == tok::langle)
+        {
+            depth++;
+        }
+        else if (From[i] == tok::rangle)
+        {
+            depth--;
+
+            if (depth == 0)
+            {
+                End = i;
+                return true;
+            }
+        }
+
+        // Earlier levels would have put parenthesis here
+        else if (From[i] == tok::semicolon || From[i] == tok::rparen || getBinaryOp(From[i]) != nullptr)
+        {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+// True if an operator just before From[Pos] would take it as the
+// start of its right operand
+static bool followsOperator(const vector<token> &From, const size_t &Pos)
+{
+    return Pos != 0 && (getBinaryOp(From[Pos - 1]) != nullptr || From[Pos - 1] == tok::caret || From[Pos - 1] == tok::at);
+}
+
+/*
+True if a statement can be split from its neighbors without
+changing what substituteByLevel does to any of them. Also finds
+the closing parenthesis of each opening one.
+
+Semicolons may only appear in parenthesis as in a C-style for
+header: Directly inside one pair. Its parts are then statements
+of their own, the last of which runs on past the closing
+parenthesis to the next semicolon.
+*/
+static bool isSplittable(const vector<token> &From, vector<size_t> &Match)
+{
+    vector<size_t> open;
+    size_t templateEnd = 0, header = 0;
+    bool inTemplate = false, inHeader = false, inHeaderTail = false;
+    Match.assign(From.size(), 0);
+
+    // An operand search back from its closing parenthesis
+    // would stop short of it
+    if (!From.empty() && From[0] == tok::lparen)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < From.size(); i++)
+    {
+        // Searches forwards skip references without looking at
+        // what follows them, and member accesses without looking
+        // at the member
+        if (From[i] == tok::caret || From[i] == tok::at)
+        {
+            if (i + 1 == From.size() || From[i + 1] == tok::lparen || From[i + 1] == tok::rparen ||
+                From[i + 1] == tok::semicolon)
+            {
+                return false;
+            }
+        }
+        else if (From[i] == tok::dot)
+        {
+            if (i == 0 || i + 1 == From.size() || isOperator(From[i + 1]) ||
+                (isOperator(From[i - 1]) && From[i - 1] != tok::rparen))
+            {
+                return false;
+            }
+        }
+
+        if (From[i] == tok::lparen)
+        {
+            open.push_back(i);
+        }
+        else if (From[i] == tok::rparen)
+        {
+            // Unmatched: Operand searches may cross statements
+            if (open.empty())
+            {
+                return false;
+            }
+
+            Match[open.back()] = i;
+
+            // Groupings which start with a grouping, like
+            // ((a) + (b)), can be stripped of unmatched parenthesis
+            if (From[open.back() + 1] == tok::lparen && Match[open.back() + 1] != i - 1)
+            {
+                return false;
+            }
+
+            // An operator after the header would search back
+            // through it
+            if (inHeader && open.back() == header)
+            {
+                if (i + 1 < From.size() && getBinaryOp(From[i + 1]) != nullptr)
+                {
+                    return false;
+                }
+
+                inHeader = false;
+                inHeaderTail = true;
+            }
+
+            open.pop_back();
+        }
+        else if (From[i] == tok::semicolon)
+        {
+            if (open.empty())
+            {
+                inHeaderTail = false;
+                continue;
+            }
+            else if (open.size() != 1 || (inHeader && open[0] != header))
+            {
+                return false;
+            }
+            else if (!inHeader)
+            {
+                // An operator before the header (or its name) would
+                // search forwards through it
+                size_t start = (open[0] != 0 && isAtom(From[open[0] - 1])) ? open[0] - 1 : open[0];
+                if (inHeaderTail || followsOperator(From, start))
+                {
+                    return false;
+                }
+
+                header = open[0];
+                inHeader = true;
+            }
+        }
+
+        // Operators missing an operand take a neighboring
+        // statement's tokens instead
+        else if (getBinaryOp(From[i]) != nullptr)
+        {
+            if (inTemplate && i > templateEnd)
+            {
+                inTemplate = false;
+            }
+            if (!inTemplate && From[i] == tok::langle)
+            {
+                inTemplate = findTemplateEnd(From, i, templateEnd);
+            }
+
+            if (inTemplate)
+            {
+                continue;
+            }
+            else if (i == 0 || From[i - 1] == tok::lparen || From[i - 1] == tok::semicolon)
+            {
+                return false;
+            }
+            else if (i + 1 < From.size() && (From[i + 1] == tok::rparen || From[i + 1] == tok::semicolon))
+            {
+                return false;
+            }
+
+            // Nor may an operand be another operator
+            else if (i + 1 < From.size() && getBinaryOp(From[i + 1]) != nullptr)
+            {
+                return false;
+            }
+        }
+    }
+
+    return open.empty();
+}
+
+// True if substituteByLevel would leave From[Begin, End) as it
+// is: The only binary operators in it are template brackets.
+static bool isPlain(const vector<token> &From, const size_t &Begin, const size_t &End)
+{
+    for (size_t i = Begin; i < End; i++)
+    {
+        if (From[i] == tok::langle)
+        {
+            // The same search for the closing bracket as level 5.
+            // Any other operator would have left a parenthesis.
+            size_t j = i + 1;
+            int depth = 1;
+            for (; j < From.size() && depth != 0; j++)
+            {
+                if (From[j] == tok::semicolon || From[j] == tok::rparen ||
+                    (getBinaryOp(From[j]) != nullptr && From[j] != tok::langle && From[j] != tok::rangle))
+                {
+                    return false;
+                }
+                else if (From[j] == tok::rangle)
+                {
+                    depth--;
+                }
+                else if (From[j] == tok::langle)
+                {
+                    depth++;
+                }
+            }
+
+            if (depth != 0)
+            {
+                return false;
+            }
+
+            i = j - 1;
+        }
+        else if (getBinaryOp(From[i]) != nullptr)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// True if the statement From[Begin, End) can be rewritten by
+// precedence climbing. End is the index of its semicolon, or the
+// end of From. A for header opening in the statement closes
+// after End, and is treated like a semicolon.
+static bool isClimbable(const vector<token> &From, const vector<size_t> &Match, const size_t &Begin,
+                        const size_t &End)
+{
+    bool hasLess = false, hasGreater = false;
+    int depth = 0, assignments = 0;
+
+    for (size_t i = Begin; i < End; i++)
+    {
+        const token &cur = From[i];
+        const binaryOp *op = getBinaryOp(cur);
+
+        if (op != nullptr)
+        {
+            // Both operands must be ordinary
+            if (i == Begin || !(isAtom(From[i - 1]) || From[i - 1] == tok::rparen))
+            {
+                return false;
+            }
+            else if (i + 1 == End || !beginsOperand(From[i + 1]))
+            {
+                return false;
+            }
+
+            // Assignments inside parenthesis or after another
+            // assignment have their operands mangled
+            if (op->power == assign_power && (depth != 0 || ++assignments > 1))
+            {
+                return false;
+            }
+
+            hasLess |= (cur == tok::langle);
+            hasGreater |= (cur == tok::rangle);
+        }
+        else if (cur == tok::lparen && Match[i] < End)
+        {
+            size_t close = Match[i];
+
+            // Empty groupings
+            if (close == i + 1 && (i == Begin || !isAtom(From[i - 1])))
+            {
+                return false;
+            }
+
+            depth++;
+        }
+        else if (cur == tok::rparen)
+        {
+            // The end of a for header, whose last part runs on
+            if (depth == 0)
+            {
+                return false;
+            }
+
+            depth--;
+        }
+        else if (cur == tok::dot)
+        {
+            // Only plain member access, not of calls or methods
+            if (i == Begin || !isAtom(From[i - 1]) || i + 1 == End || !isAtom(From[i + 1]))
+            {
+                return false;
+            }
+            else if (i + 2 < End && From[i + 2] == tok::lparen)
+            {
+                return false;
+            }
+        }
+        else if (cur == tok::caret || cur == tok::at)
+        {
+            // References and dereferences of names only
+            if (i + 1 == End || !(isAtom(From[i + 1]) || From[i + 1] == tok::caret || From[i + 1] == tok::at))
+            {
+                return false;
+            }
+        }
+    }
+
+    // Could be templating
+    return !(hasLess && hasGreater);
+}
+
+// Walks one statement, appending its rewritten tokens
+class precedenceClimber
+{
+  public:
+    precedenceClimber(const vector<token> &From, const vector<size_t> &Match)
+        : from(From), match(Match), lparen("("), comma(","), rparen(")")
+    {
+    }
+
+    // Rewrites From[Pos, End) as a series of expressions
+    void sequence(size_t &Pos, const size_t &End, vector<token> &Out)
+    {
+        while (Pos < End)
+        {
+            if (from[Pos] == tok::comma)
+            {
+                Out.push_back(from[Pos]);
+                Pos++;
+            }
+            else
+            {
+                expression(Pos, End, assign_power, Out);
+            }
+        }
+
+        return;
+    }
+
+  protected:
+    // Rewrites the longest expression at Pos whose operators all
+    // bind at least as tightly as MinPower. Operands are written
+    // straight to Out; Once the last operator is known, the names
+    // of all of them are put in front.
+    void expression(size_t &Pos, const size_t &End, const int &MinPower, vector<token> &Out)
+    {
+        size_t start = Out.size(), base = ops.size();
+        primary(Pos, End, Out);
+
+        while (Pos < End)
+        {
+            const binaryOp *op = getBinaryOp(from[Pos]);
+            if (op == nullptr || op->power < MinPower)
+            {
+                break;
+            }
+
+            Pos++;
+
+            // Later left operands begin with an operator's name
+            if (ops.size() == base)
+            {
+                strip(Out, start);
+            }
+            ops.push_back(op);
+
+            Out.push_back(comma);
+            size_t rhsStart = Out.size();
+
+            if (op->power == assign_power)
+            {
+                sequence(Pos, End, Out);
+            }
+            else
+            {
+                // Left associative
+                expression(Pos, End, op->power + 1, Out);
+            }
+
+            strip(Out, rhsStart);
+            Out.push_back(rparen);
+        }
+
+        if (ops.size() != base)
+        {
+            prefix.clear();
+            for (size_t i = ops.size(); i > base; i--)
+            {
+                prefix.push_back(ops[i - 1]->name);
+                prefix.push_back(lparen);
+            }
+
+            Out.insert(Out.begin() + start, prefix.begin(), prefix.end());
+            ops.resize(base);
+        }
+
+        return;
+    }
+
+    // A name, call or grouping, with any references,
+    // dereferences and member accesses. A for header's opening
+    // parenthesis stands alone.
+    void primary(size_t &Pos, const size_t &End, vector<token> &Out)
+    {
+        while (from[Pos] == tok::caret || from[Pos] == tok::at)
+        {
+            Out.push_back(from[Pos]);
+            Pos++;
+        }
+
+        if (from[Pos] == tok::lparen && match[Pos] >= End)
+        {
+            Out.push_back(from[Pos]);
+            Pos++;
+            return;
+        }
+        else if (from[Pos] != tok::lparen)
+        {
+            Out.push_back(from[Pos]);
+            Pos++;
+        }
+
+        // A grouping, or the arguments of a call
+        if (Pos < End && from[Pos] == tok::lparen && match[Pos] < End)
+        {
+            size_t close = match[Pos];
+
+            Out.push_back(from[Pos]);
+            Pos++;
+            sequence(Pos, close, Out);
+            Out.push_back(from[close]);
+            Pos = close + 1;
+        }
+
+        while (Pos + 1 < End && from[Pos] == tok::dot)
+        {
+            Out.push_back(from[Pos]);
+            Out.push_back(from[Pos + 1]);
+            Pos += 2;
+        }
+
+        return;
+    }
+
+    // Removes any enclosing parenthesis from Out[Start, end)
+    static void strip(vector<token> &Out, const size_t &Start)
+    {
+        size_t count = 0;
+        while (Start + count < Out.size() - count && Out[Start + count] == tok::lparen &&
+               Out[Out.size() - 1 - count] == tok::rparen)
+        {
+            count++;
+        }
+
+        if (count != 0)
+        {
+            Out.resize(Out.size() - count);
+            Out.erase(Out.begin() + Start, Out.begin() + Start + count);
+        }
+
+        return;
+    }
+
+    const vector<token> &from;
+    const vector<size_t> &match;
+    const token lparen, comma, rparen;
+
+    // The operators of the expressions being rewritten, and
+    // space for the names of one's
+    vector<const binaryOp *> ops;
+    vector<token> prefix;
+};
+
+void operatorSub(tokenBuffer &From)
+{
+    vector<token> from = From.toVector(), out;
+    vector<size_t> match;
+
+    if (!isSplittable(from, match))
+    {
+        substituteByLevel(From);
+        return;
+    }
+
+    precedenceClimber climber(from, match);
+    tokenBuffer statement;
+    out.reserve(from.size() * 2);
+
+    size_t begin = 0;
+    while (begin < from.size())
+    {
+        size_t end = begin;
+        while (end < from.size() && from[end] != tok::semicolon)
+        {
+            end++;
+        }
+
+        if (isPlain(from, begin, end))
+        {
+            out.insert(out.end(), from.begin() + begin, from.begin() + end);
+        }
+
+        // Operand searches stop short of a member access at the
+        // end of From
+        else if (isClimbable(from, match, begin, end) &&
+                 !(end == from.size() && end >= 2 && from[end - 2] == tok::dot))
+        {
+            size_t pos = begin;
+            climber.sequence(pos, end, out);
+        }
+        else
+        {
+            // Keep the surrounding semicolons, so that operand
+            // searches stop where they would have
+            size_t first = (begin == 0 ? 0 : begin - 1);
+            size_t last = (end < from.size() ? end + 1 : end);
+
+            statement.clear();
+            for (size_t i = first; i < last; i++)
+            {
+                statement.push_back(from[i]);
+            }
+
+            substituteByLevel(statement);
+
+            for (size_t i = begin - first; i + (last - end) < statement.size(); i++)
+            {
+                out.push_back(statement[i]);
+            }
+        }
+
+        if (end < from.size())
+        {
+            out.push_back(from[end]);
+        }
+
+        begin = end + 1;
+    }
+
+    From = std::move(out);
+    return;
+}
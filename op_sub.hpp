@@ -13,6 +13,7 @@ Should be done after macros
 #define OP_SUB_HPP
 
 #include "symbol_table.hpp"
+#include "token_buffer.hpp"
 #include <iostream>
 #include <string>
 #include <vector>
@@ -22,6 +23,6 @@ using namespace std;
 Takes entire lexed token stream. After call, no operators
 should remain.
 */
-void operatorSub(vector<string> &From);
+void operatorSub(tokenBuffer &From);
 
 #endif
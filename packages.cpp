@@ -8,6 +8,7 @@ GPLv3 held by author
 
 #include "packages.hpp"
 #include "tags.hpp"
+#include <filesystem>
 
 /*
 File oak_package_info.txt:
@@ -493,7 +494,7 @@ vector<string> getPackageFiles(const string &Name)
     // If package is not already loaded
     if (packages.count(Name) == 0)
     {
-        if (system(("[ -d /usr/include/oak/" + Name + " ]").c_str()) == 0)
+        if (filesystem::is_directory("/usr/include/oak/" + Name))
         {
             // Installed, but not loaded; Load and continue
             loadPackageInfo("/usr/include/oak/" + Name + "/" + INFO_FILE);
@@ -7,8 +7,16 @@ GPLv3 held by author
 */
 
 #include "reconstruct.hpp"
+#include "macros.hpp"
 #include "sequence_resources.hpp"
+#include <filesystem>
+#include <queue>
 #include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+// The signature of main, as last emitted in macro mode
+static string macroMainArguments = "void", macroMainReturnType = "void";
 
 map<string, unsigned long long> atomics = {{"u8", 1},  {"i8", 1},  {"u16", 2},   {"i16", 2},   {"u32", 4},
                                            {"i32", 4}, {"u64", 8}, {"i64", 8},   {"u128", 16}, {"i128", 16},
@@ -45,14 +53,134 @@ string purifyStr(const string &What)
     return (out == "" ? "NULL_STR" : out);
 }
 
+// Appends every C identifier in What to Out
+static void getIdentifiers(const string &What, vector<string> &Out)
+{
+    size_t i = 0;
+    while (i < What.size())
+    {
+        if (isalpha(What[i]) || What[i] == '_')
+        {
+            size_t start = i;
+            while (i < What.size() && (isalnum(What[i]) || What[i] == '_'))
+            {
+                i++;
+            }
+
+            Out.push_back(What.substr(start, i - start));
+        }
+        else if (isdigit(What[i]))
+        {
+            // Skip numeric literals, suffixes included
+            while (i < What.size() && (isalnum(What[i]) || What[i] == '_' || What[i] == '.'))
+            {
+                i++;
+            }
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return;
+}
+
+// Gets the C declaration of a symbol from the table and, if it
+// is a function with a body, its definition
+static void symbolToC(const string &Name, __multiTableSymbol &Symbol, string &Declaration, string &Definition)
+{
+    try
+    {
+        if (Symbol.type[0].info == function)
+        {
+            Declaration = toStrCFunction(&Symbol.type, Name);
+
+            if (Symbol.seq->items.size() != 0)
+            {
+                Definition = toC(*Symbol.seq);
+            }
+        }
+        else
+        {
+            Declaration = toStrC(&Symbol.type);
+        }
+    }
+    catch (runtime_error &e)
+    {
+        throw sequencing_error("During processing of symbol '" + Name + "' w/ type '" + toStr(&Symbol.type) +
+                               "' from " + Symbol.sourceFilePath + ": " + e.what());
+    }
+
+    return;
+}
+
+// Gets the names of the header and body saved for Name
+static pair<string, string> getSaveNames(const string &Name)
+{
+    string rootName;
+
+    if (Name.substr(Name.size() - 4) == ".oak")
+    {
+        rootName = Name.substr(0, Name.size() - 4);
+    }
+    else
+    {
+        rootName = Name;
+    }
+
+    rootName = purifyStr(rootName);
+
+    return make_pair(".oak_build/" + rootName + ".h", ".oak_build/" + rootName + ".c");
+}
+
+// Size of the buffers given to the output files
+#define SAVE_BUFFER_SIZE (1 << 16)
+
 pair<string, string> reconstructAndSave(const string &Name)
 {
-    stringstream header, body;
-    reconstruct(Name, header, body);
-    return save(header, body, Name);
+    pair<string, string> names = getSaveNames(Name);
+    filesystem::create_directories(".oak_build");
+
+    // The C is written straight to the files as it is made
+    static char headerBuffer[SAVE_BUFFER_SIZE], bodyBuffer[SAVE_BUFFER_SIZE];
+    ofstream headerFile, bodyFile;
+    headerFile.rdbuf()->pubsetbuf(headerBuffer, SAVE_BUFFER_SIZE);
+    bodyFile.rdbuf()->pubsetbuf(bodyBuffer, SAVE_BUFFER_SIZE);
+
+    headerFile.open(names.first);
+    if (!headerFile.is_open())
+    {
+        throw runtime_error("Failed to open file `" + names.first + "`");
+    }
+
+    bodyFile.open(names.second);
+    if (!bodyFile.is_open())
+    {
+        throw runtime_error("Failed to open file `" + names.second + "`");
+    }
+
+    try
+    {
+        reconstruct(Name, headerFile, bodyFile);
+    }
+    catch (...)
+    {
+        // Leave nothing half-written behind
+        headerFile.close();
+        bodyFile.close();
+        filesystem::remove(names.first);
+        filesystem::remove(names.second);
+        throw;
+    }
+
+    headerFile.close();
+    bodyFile.close();
+
+    return names;
 }
 
-void reconstruct(const string &Name, stringstream &header, stringstream &body)
+void reconstruct(const string &Name, ostream &header, ostream &body)
 {
     // Purify name
     string rootName;
@@ -92,125 +220,223 @@ void reconstruct(const string &Name, stringstream &header, stringstream &body)
         }
     }
 
-    // Step A3: Struct definitions
+    // Step A3: Find what is live. With a main, that is main, the
+    // globals, every function they name and every struct any of
+    // those name, recursively. Without one, it is everything.
+    vector<string> symbolNames;
+    vector<__multiTableSymbol *> symbols;
+    unordered_map<string, vector<size_t>> symbolsByCName;
+    bool hasMain = table.find("main") != table.end() && !table.find("main")->second.empty();
+
+    for (auto &entry : table)
     {
-        header << "// Struct and Enum definitions\n";
-        for (auto name : structOrder)
+        for (auto &s : entry.second)
         {
-            if (enumData.count(name) != 0)
+            if (hasMain && s.type[0].info == function && entry.first != "main")
             {
-                header << enumToC(name) << '\n';
-                continue;
+                symbolsByCName[mangleSymb(entry.first, mangleType(s.type))].push_back(symbols.size());
             }
 
-            header << "struct " << name << "\n{\n";
+            symbolNames.push_back(entry.first);
+            symbols.push_back(&s);
+        }
+    }
 
-            for (auto m : structData[name].order)
-            {
-                header << toStrC(&structData[name].members[m], m) << ";\n";
-            }
+    vector<string> declarations(symbols.size());
+    vector<bool> isLive(symbols.size(), false);
+    unordered_set<string> usedNames;
+    vector<string> identifiers;
+    string definition;
 
-            header << "};\n";
+    queue<size_t> toVisit;
+    for (size_t i = 0; i < symbols.size(); i++)
+    {
+        if (!hasMain || symbols[i]->type[0].info != function || symbolNames[i] == "main")
+        {
+            isLive[i] = true;
+            toVisit.push(i);
         }
     }
 
-    // Step A4: Insert global definitions into header
-    // (Translate Oak syntax into C syntax)
+    while (!toVisit.empty())
     {
-        header << "// Global function definitions\n";
+        size_t i = toVisit.front();
+        toVisit.pop();
 
-        for (auto entry : table)
+        definition.clear();
+        symbolToC(symbolNames[i], *symbols[i], declarations[i], definition);
+
+        // Definitions go straight to the body as they are made, so
+        // only one is held at a time. The header is written after.
+        if (symbols[i]->type[0].info == function)
+        {
+            if (symbols[i]->seq->items.size() != 0)
+            {
+                body << declarations[i] << "\n" << (definition == "" ? ";" : definition);
+            }
+        }
+        else
         {
-            string name = entry.first;
+            body << declarations[i] << " " << symbolNames[i] << ";\n";
+        }
+
+        if (!hasMain)
+        {
+            continue;
+        }
 
-            for (__multiTableSymbol s : entry.second)
+        identifiers.clear();
+        getIdentifiers(declarations[i], identifiers);
+        getIdentifiers(definition, identifiers);
+
+        for (const auto &identifier : identifiers)
+        {
+            usedNames.insert(identifier);
+
+            auto found = symbolsByCName.find(identifier);
+            if (found != symbolsByCName.end())
             {
-                try
+                for (const auto &j : found->second)
                 {
-                    if (s.type[0].info == function)
+                    if (!isLive[j])
                     {
-                        string toAdd = toStrCFunction(&s.type, name);
+                        isLive[j] = true;
+                        toVisit.push(j);
+                    }
+                }
+            }
+        }
+    }
+
+    map<string, string> structDefinitions;
+    for (auto name : structOrder)
+    {
+        if (enumData.count(name) != 0)
+        {
+            structDefinitions[name] = enumToC(name) + '\n';
+            continue;
+        }
 
-                        header << toAdd << ";\n";
+        string definition = "struct " + name + "\n{\n";
 
-                        if (s.seq.items.size() != 0)
-                        {
-                            string definition = toC(s.seq);
+        for (auto m : structData[name].order)
+        {
+            definition += toStrC(&structData[name].members[m], m) + ";\n";
+        }
 
-                            body << toAdd << "\n" << (definition == "" ? ";" : definition);
-                        }
-                    }
-                    else
-                    {
-                        string toAdd = toStrC(&s.type);
+        definition += "};\n";
+        structDefinitions[name] = definition;
+    }
 
-                        header << "extern " << toAdd << " " << name << ";\n";
-                        body << toAdd << " " << name << ";\n";
-                    }
-                }
-                catch (runtime_error &e)
+    set<string> liveStructs;
+    if (hasMain)
+    {
+        vector<string> structsToVisit;
+        for (auto name : structOrder)
+        {
+            if (usedNames.count(name) != 0 && liveStructs.insert(name).second)
+            {
+                structsToVisit.push_back(name);
+            }
+        }
+
+        while (!structsToVisit.empty())
+        {
+            string name = structsToVisit.back();
+            structsToVisit.pop_back();
+
+            identifiers.clear();
+            getIdentifiers(structDefinitions[name], identifiers);
+
+            for (const auto &identifier : identifiers)
+            {
+                if (structDefinitions.count(identifier) != 0 && liveStructs.insert(identifier).second)
                 {
-                    throw sequencing_error("During processing of symbol '" + name + "' w/ type '" + toStr(&s.type) +
-                                           "' from " + s.sourceFilePath + ": " + e.what());
+                    structsToVisit.push_back(identifier);
                 }
             }
         }
     }
 
-    // End header enclosure
-    header << "\n#endif\n";
+    // Step A4: Struct definitions
+    {
+        header << "// Struct and Enum definitions\n";
+        for (auto name : structOrder)
+        {
+            if (!hasMain || liveStructs.count(name) != 0)
+            {
+                header << structDefinitions[name];
+            }
+        }
+    }
 
-    return;
-}
+    // Step A5: Insert global declarations into header
+    {
+        header << "// Global function definitions\n";
 
-// Save reconstructed files and return compilation command
-pair<string, string> save(const stringstream &header, const stringstream &body, const string &Name)
-{
-    string rootName, headerName, bodyName;
+        for (size_t i = 0; i < symbols.size(); i++)
+        {
+            if (!isLive[i])
+            {
+                continue;
+            }
 
-    if (Name.substr(Name.size() - 4) == ".oak")
-    {
-        rootName = Name.substr(0, Name.size() - 4);
+            if (symbols[i]->type[0].info == function)
+            {
+                header << declarations[i] << ";\n";
+            }
+            else
+            {
+                header << "extern " << declarations[i] << " " << symbolNames[i] << ";\n";
+            }
+        }
     }
-    else
+
+    // Step A6: Macros are run through a host main
+    if (isMacroCall && table.count("main") != 0)
     {
-        rootName = Name;
+        body << macroHostSource(macroMainArguments, macroMainReturnType);
     }
 
-    rootName = purifyStr(rootName);
+    // End header enclosure
+    header << "\n#endif\n";
 
-    smartSystem("mkdir -p .oak_build");
+    return;
+}
 
-    headerName = ".oak_build/" + rootName + ".h";
-    bodyName = ".oak_build/" + rootName + ".c";
+// Save reconstructed files and return compilation command
+pair<string, string> save(const stringstream &header, const stringstream &body, const string &Name)
+{
+    pair<string, string> names = getSaveNames(Name);
+    filesystem::create_directories(".oak_build");
 
     // Save header
     {
-        ofstream headerFile(headerName);
+        ofstream headerFile(names.first);
         if (!headerFile.is_open())
         {
-            throw runtime_error("Failed to open file `" + headerName + "`");
+            throw runtime_error("Failed to open file `" + names.first + "`");
         }
 
-        headerFile << header.str();
+        headerFile << header.rdbuf();
 
         headerFile.close();
     }
 
     // Save body
     {
-        ofstream bodyFile(bodyName);
+        ofstream bodyFile(names.second);
         if (!bodyFile.is_open())
         {
-            throw runtime_error("Failed to open file `" + bodyName + "`");
+            throw runtime_error("Failed to open file `" + names.second + "`");
         }
 
-        bodyFile << body.str();
+        bodyFile << body.rdbuf();
 
         bodyFile.close();
     }
 
-    return make_pair(headerName, bodyName);
+    return names;
 }
 
 // This is separate due to complexity
@@ -304,6 +530,13 @@ string toStrCFunction(const Type *What, const string &Name, const unsigned int &
         // Mangle to disambiguate identical functions
         out = returnType + " " + mangleSymb(Name, mangleType(*What)) + "(" + arguments + ")";
     }
+    else if (isMacroCall)
+    {
+        // The real main is the macro host, appended by reconstruct
+        out = returnType + " " MACRO_MAIN_NAME "(" + arguments + ")";
+        macroMainArguments = arguments;
+        macroMainReturnType = returnType;
+    }
     else
     {
         out = returnType + " main(" + arguments + ")";
@@ -338,7 +571,7 @@ string toStrCFunctionRef(const Type *What, const string &Name, const unsigned in
     // Then some number of args, possibly containing maps
     do
     {
-        typeNode &cur = (*What)[i];
+        const typeNode &cur = (*What)[i];
 
         if (cur.info == function)
         {
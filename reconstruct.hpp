@@ -33,8 +33,9 @@ using namespace std;
 // Removes illegal characters
 string purifyStr(const string &What);
 
-// Reconstruct the existing symbol table into C++
-void reconstruct(const string &Name, stringstream &header, stringstream &body);
+// Reconstruct the existing symbol table into C++, writing the C
+// to the given streams as it is made
+void reconstruct(const string &Name, ostream &header, ostream &body);
 
 // Contains all the atomic types (ints, floats, bools, etc)
 extern map<string, unsigned long long> atomics;
@@ -43,8 +44,8 @@ extern map<string, unsigned long long> atomics;
 // Return pair<sstream, sstream>{header, body};
 pair<string, string> save(const stringstream &header, const stringstream &body, const string &Name);
 
-// Call reconstruct and save, without fiddling with stringstreams
-// returns headerName, bodyName
+// Call reconstruct straight into the saved files, without any
+// stringstreams; returns headerName, bodyName
 pair<string, string> reconstructAndSave(const string &Name);
 
 // Return the C++ format-version of a type, to be followed by symbol name
@@ -56,6 +57,9 @@ string toStrCFunction(const Type *What, const string &Name, const unsigned int &
 // Other type of C++ function; IE bool (*what)(const bool &What);
 string toStrCFunctionRef(const Type *What, const string &Name, const unsigned int &pos = 0);
 
+// Cache for enumToC; Must be cleared if enumData is replaced
+extern map<string, string> toStrCEnumCache;
+
 string enumToC(const string &name);
 
 #endif
@@ -1,75 +1,242 @@
 #include "rules.hpp"
+#include <algorithm>
 using namespace std;
 
 map<string, rule> rules;
 vector<string> activeRules, dialectRules;
 map<string, vector<string>> bundles;
-map<string, void (*)(vector<string> &, int &, rule &)> engines;
+map<string, void (*)(tokenBuffer &, int &, rule &)> engines = {{"sapling", doRuleAcorn}};
 
 bool doRuleLogFile = false;
 
-// I is the point in Lexed at which a macro name was found
-// CONSUMPTIVE!
-vector<string> getMacroArgs(vector<string> &lexed, const int &i)
+/*
+The rules doRules tries, in the order it tries them. Most
+Sapling rules begin with a literal, and can only ever match
+at that token; These are indexed by the ID of that token, so
+that each token only visits the rules which could start there.
+Each list holds positions in ruleOrder, in increasing order.
+*/
+static vector<rule *> ruleOrder;
+static unordered_map<unsigned int, vector<int>> rulesByFirstToken;
+static vector<int> rulesForAnyToken;
+
+// The items of a suite, split exactly as matching always has
+static vector<token> splitSuite(const string &Pattern, const size_t &Start)
 {
-    vector<string> out;
+    vector<token> out;
+    size_t start, end = Start;
+
+    while (end < Pattern.size())
+    {
+        // Advance end to the next dollar sign
+        start = end;
+        do
+        {
+            end++;
+        } while (end < Pattern.size() && Pattern[end] != '$');
+
+        if (end >= Pattern.size())
+        {
+            break;
+        }
+
+        out.push_back(token(Pattern.substr(start, end - start)));
+    }
 
-    lexed.erase(lexed.begin() + i);
+    return out;
+}
 
-    while (lexed[i].size() > 2 && lexed[i].substr(0, 2) == "//")
+void compileRule(rule &What)
+{
+    What.compiled.clear();
+    What.compiled.reserve(What.inputPattern.size());
+
+    for (const token &t : What.inputPattern)
     {
-        lexed.erase(lexed.begin() + i);
+        const string &match = t.str();
+        patternItem item;
+        item.kind = pattern_literal;
+        item.what = t;
+
+        if (match == "$$")
+        {
+            item.kind = pattern_wildcard;
+        }
+        else if (match == "$*")
+        {
+            item.kind = pattern_glob;
+        }
+        else if (match == "$+")
+        {
+            item.kind = pattern_plus_glob;
+        }
+        else if (match == "$~")
+        {
+            item.kind = pattern_memory_clear;
+        }
+        else if (match.size() == 3 && match.compare(0, 2, "$>") == 0)
+        {
+            item.kind = pattern_memory_pipe;
+            item.name = match.substr(0, 1) + match.substr(2, 1);
+        }
+        else if (match.size() > 2 && match.compare(0, 2, "$-") == 0)
+        {
+            item.kind = pattern_backtrack;
+            item.what = match.substr(2);
+        }
+        else if (match.size() > 4 && match.compare(0, 4, "$/<$") == 0)
+        {
+            item.kind = pattern_not_prefixed;
+            item.what = match.substr(4);
+        }
+        else if (match.size() > 4 && match.compare(0, 4, "$/>$") == 0)
+        {
+            item.kind = pattern_not_followed;
+            item.what = match.substr(4);
+        }
+        else if (match.size() > 3 && match.compare(0, 3, "$[$") == 0)
+        {
+            item.kind = pattern_suite;
+            item.options = splitSuite(match, 3);
+        }
+        else if (match.size() > 4 && match.compare(0, 4, "$/[$") == 0)
+        {
+            item.kind = pattern_negated_suite;
+            item.options = splitSuite(match, 4);
+        }
+        else if (match.size() > 7 && match.compare(0, 3, "$<$") == 0)
+        {
+            size_t endOfOpener = 3;
+            while (endOfOpener < match.size() && match[endOfOpener] != '$')
+            {
+                endOfOpener++;
+            }
+
+            size_t endOfCloser = endOfOpener + 1;
+            while (endOfCloser < match.size() && match[endOfCloser] != '$')
+            {
+                endOfCloser++;
+            }
+
+            item.kind = pattern_pair;
+            item.what = match.substr(3, endOfOpener - 3);
+            item.closer = match.substr(endOfOpener + 1, endOfCloser - endOfOpener - 1);
+        }
+        else if (match.size() == 3 && match.compare(0, 2, "$*") == 0)
+        {
+            item.kind = pattern_variable_glob;
+            item.name = match.substr(0, 1) + match.substr(2, 1);
+        }
+        else if (!match.empty() && match[0] == '$')
+        {
+            item.kind = pattern_variable;
+            item.name = match;
+        }
+
+        What.compiled.push_back(item);
     }
 
-    if (lexed[i] != "(")
+    return;
+}
+
+// Rebuilds ruleOrder and its index from the rule name lists
+static void indexRules()
+{
+    ruleOrder.clear();
+    rulesByFirstToken.clear();
+    rulesForAnyToken.clear();
+
+    for (size_t ruleIndex = 0; ruleIndex < dialectRules.size() + activeRules.size(); ruleIndex++)
     {
-        throw runtime_error("Internal error; Malformed call to getMacroArgs.");
+        const string &name = ruleIndex < dialectRules.size() ? dialectRules[ruleIndex]
+                                                             : activeRules[ruleIndex - dialectRules.size()];
+
+        auto found = rules.find(name);
+        if (found == rules.end())
+        {
+            continue;
+        }
+
+        rule &curRule = found->second;
+        int position = ruleOrder.size();
+        ruleOrder.push_back(&curRule);
+
+        if (curRule.doRule == doRuleAcorn && !curRule.compiled.empty() &&
+            curRule.compiled.front().kind == pattern_literal)
+        {
+            rulesByFirstToken[curRule.compiled.front().what.id].push_back(position);
+        }
+        else
+        {
+            rulesForAnyToken.push_back(position);
+        }
     }
 
-    // Erase opening parenthesis
-    lexed.erase(lexed.begin() + i);
+    // Rules which can start anywhere are candidates at every token
+    for (auto &p : rulesByFirstToken)
+    {
+        vector<int> merged;
+        merged.reserve(p.second.size() + rulesForAnyToken.size());
+        merge(p.second.begin(), p.second.end(), rulesForAnyToken.begin(), rulesForAnyToken.end(),
+              back_inserter(merged));
+        p.second = merged;
+    }
+
+    return;
+}
 
-    while (lexed[i].size() > 2 && lexed[i].substr(0, 2) == "//")
+// I is the point in Lexed at which a macro name was found
+// CONSUMPTIVE!
+vector<string> getMacroArgs(tokenBuffer &lexed, const int &i)
+{
+    vector<string> out;
+
+    lexed.erase(i);
+
+    if (lexed[i] != tok::lparen)
     {
-        lexed.erase(lexed.begin() + i);
+        throw runtime_error("Internal error; Malformed call to getMacroArgs.");
     }
 
+    // Erase opening parenthesis
+    lexed.erase(i);
+
     string cur = "";
     int count = 1;
 
-    while (!lexed.empty() && lexed[i] != ";")
+    while (!lexed.empty() && lexed[i] != tok::semicolon)
     {
-        if (lexed[i] == "(")
+        if (lexed[i] == tok::lparen)
         {
             count++;
         }
-        else if (lexed[i] == ")")
+        else if (lexed[i] == tok::rparen)
         {
             count--;
         }
 
-        if ((lexed[i] == "," && count == 1) || (lexed[i] == ")" && count == 0))
+        if ((lexed[i] == tok::comma && count == 1) || (lexed[i] == tok::rparen && count == 0))
         {
             out.push_back(cur);
             cur = "";
         }
-        else if (lexed[i].size() < 3 || lexed[i].substr(0, 2) != "//")
+        else
         {
             cur += lexed[i];
         }
 
-        lexed.erase(lexed.begin() + i);
+        lexed.erase(i);
     }
 
     if (!lexed.empty())
     {
-        lexed.erase(lexed.begin() + i);
+        lexed.erase(i);
     }
 
     return out;
 }
 
-void doRules(vector<string> &From)
+void doRules(tokenBuffer &From)
 {
     ofstream ruleLogFile;
     if (doRuleLogFile)
@@ -83,17 +250,14 @@ void doRules(vector<string> &From)
         ruleLogFile << "\n\n/////////// In file " << curFile << " ///////////\n\n";
     }
 
+    indexRules();
+
     for (int i = 0; i < From.size(); i++)
     {
         // cout << __FILE__ << ' ' << __LINE__ << ' ' << curFile << ' ' << i << '\t' << From[i] << '\n';
 
-        if (From[i].size() >= 2 && From[i].substr(0, 2) == "//")
-        {
-            continue;
-        }
-
         // Add a new rule to the list of all rules
-        else if (From[i] == "new_rule!")
+        if (From[i] == tok::new_rule_macro)
         {
             auto args = getMacroArgs(From, i);
             for (int j = 0; j < args.size(); j++)
@@ -126,12 +290,15 @@ void doRules(vector<string> &From)
 
             toAdd.inputPattern = lex(args[1]);
             toAdd.outputPattern = lex(args[2]);
+            compileRule(toAdd);
 
             rules[name] = toAdd;
+            indexRules();
+            i--;
         }
 
         // Use a rule that already exists
-        else if (From[i] == "use_rule!")
+        else if (From[i] == tok::use_rule_macro)
         {
             // use_rule!("NAME", "NAME", ...);
 
@@ -166,10 +333,13 @@ void doRules(vector<string> &From)
                     activeRules.push_back(arg);
                 }
             }
+
+            indexRules();
+            i--;
         }
 
         // Stop using a rule that is in use
-        else if (From[i] == "rem_rule!")
+        else if (From[i] == tok::rem_rule_macro)
         {
             // rem_rule!("NAME", "NAME", ...);
 
@@ -204,10 +374,13 @@ void doRules(vector<string> &From)
 
                 rm_assert(found, "Rule '" + arg + "' is not in use.");
             }
+
+            indexRules();
+            i--;
         }
 
         // Bundle multiple rules into one
-        else if (From[i] == "bundle_rule!")
+        else if (From[i] == tok::bundle_rule_macro)
         {
             // bundle_rule!("BUNDLE_NAME", "NAME", ...);
 
@@ -229,34 +402,30 @@ void doRules(vector<string> &From)
             {
                 bundles[name].push_back(args[j]);
             }
+
+            i--;
         }
 
         // Regular case; Non-rule-macro symbol. Check against active rules.
         else
         {
-            for (int ruleIndex = 0; ruleIndex < dialectRules.size() + activeRules.size(); ruleIndex++)
+            // A rule may replace From[i], so the candidates are
+            // looked up again after every attempt
+            int next = 0;
+            while ((size_t)i < From.size())
             {
-                // cout << "On rule " << ruleIndex << '\n';
+                auto found = rulesByFirstToken.find(From[i].id);
+                const vector<int> &candidates =
+                    (found == rulesByFirstToken.end()) ? rulesForAnyToken : found->second;
 
-                rule curRule;
-                if (ruleIndex < dialectRules.size())
+                auto candidate = lower_bound(candidates.begin(), candidates.end(), next);
+                if (candidate == candidates.end())
                 {
-                    if (rules.count(dialectRules[ruleIndex]) == 0)
-                    {
-                        continue;
-                    }
-
-                    curRule = rules[dialectRules[ruleIndex]];
+                    break;
                 }
-                else
-                {
-                    if (rules.count(activeRules[ruleIndex - dialectRules.size()]) == 0)
-                    {
-                        continue;
-                    }
 
-                    curRule = rules[activeRules[ruleIndex - dialectRules.size()]];
-                }
+                next = *candidate + 1;
+                rule &curRule = *ruleOrder[*candidate];
 
                 if (i + curRule.inputPattern.size() >= From.size())
                 {
@@ -374,6 +543,7 @@ void loadDialectFile(const string &File)
 
             // Fetch engine based on current
             toAdd.doRule = engines[engine];
+            compileRule(toAdd);
 
             // Insert into rules list
             rules[name] = toAdd;
@@ -409,26 +579,20 @@ void loadDialectFile(const string &File)
     return;
 }
 
-void doRuleAcorn(vector<string> &From, int &i, rule &curRule)
+void doRuleAcorn(tokenBuffer &From, int &i, rule &curRule)
 {
-    int posInFrom = i;
-    vector<string> memory;
+    if (curRule.compiled.size() != curRule.inputPattern.size())
+    {
+        compileRule(curRule);
+    }
+
+    size_t posInFrom = i;
+    vector<token> memory;
     map<string, string> ruleVars;
     bool isMatch = true;
-    for (int k = 0; posInFrom < From.size() && k < curRule.inputPattern.size(); k++)
+    for (size_t k = 0; posInFrom < From.size() && k < curRule.compiled.size(); k++)
     {
-        string match = curRule.inputPattern[k];
-
-        while (From[posInFrom].size() >= 2 && From[posInFrom].substr(0, 2) == "//")
-        {
-            posInFrom++;
-
-            if (posInFrom >= From.size())
-            {
-                isMatch = false;
-                break;
-            }
-        }
+        const patternItem &match = curRule.compiled[k];
 
         if (posInFrom >= From.size())
         {
@@ -443,51 +607,21 @@ void doRuleAcorn(vector<string> &From, int &i, rule &curRule)
             break;
         }
 
-        // Wildcard; Un-stored match
-        if (match == "$$")
+        switch (match.kind)
         {
+        // Wildcard; Un-stored match
+        case pattern_wildcard:
             memory.push_back(From[posInFrom]);
-
             posInFrom++;
-            continue;
-        }
+            break;
 
         // Globs; Un-stored multi-symbol matches
-        else if (match == "$*")
-        {
+        case pattern_glob:
+        case pattern_plus_glob: {
             throw_assert(k + 1 < curRule.inputPattern.size());
-            string nextSymb = curRule.inputPattern[k + 1];
+            const token &nextSymb = curRule.inputPattern[k + 1];
 
-            while (From[posInFrom] != nextSymb)
-            {
-                memory.push_back(From[posInFrom]);
-                posInFrom++;
-
-                if (posInFrom >= From.size())
-                {
-                    isMatch = false;
-                    break;
-                }
-
-                while (From[posInFrom].size() > 1 && From[posInFrom].substr(0, 2) == "//")
-                {
-                    posInFrom++;
-                    if (posInFrom >= From.size())
-                    {
-                        isMatch = false;
-                        break;
-                    }
-                }
-            }
-
-            continue;
-        }
-        else if (match == "$+")
-        {
-            throw_assert(k + 1 < curRule.inputPattern.size());
-            string nextSymb = curRule.inputPattern[k + 1];
-
-            if (From[posInFrom] == nextSymb)
+            if (match.kind == pattern_plus_glob && From[posInFrom] == nextSymb)
             {
                 isMatch = false;
             }
@@ -502,234 +636,141 @@ void doRuleAcorn(vector<string> &From, int &i, rule &curRule)
                     isMatch = false;
                     break;
                 }
-
-                while (From[posInFrom].size() > 1 && From[posInFrom].substr(0, 2) == "//")
-                {
-                    posInFrom++;
-                    if (posInFrom >= From.size())
-                    {
-                        isMatch = false;
-                        break;
-                    }
-                }
             }
 
-            continue;
+            break;
         }
 
         // Memory clear
-        else if (match == "$~")
-        {
+        case pattern_memory_clear:
             memory.clear();
-            continue;
-        }
+            break;
 
         // Pipe memory onto end of variable
-        else if (match.size() == 3 && match.substr(0, 2) == "$>")
-        {
-            string name = match.substr(0, 1) + match.substr(2, 1);
-
+        case pattern_memory_pipe: {
             string concatenatedMemory = "";
-            for (const string &item : memory)
+            for (const token &item : memory)
             {
                 concatenatedMemory.append(item);
                 concatenatedMemory.append(" ");
             }
 
-            if (ruleVars.count(name) == 0)
+            if (ruleVars.count(match.name) == 0)
             {
-                ruleVars[name] += " " + concatenatedMemory;
+                ruleVars[match.name] += " " + concatenatedMemory;
             }
             else
             {
-                ruleVars[name] = concatenatedMemory;
+                ruleVars[match.name] = concatenatedMemory;
             }
 
-            continue;
+            break;
         }
 
         // Go back to previous match item unless literal
-        else if (match.size() > 2 && match.substr(0, 2) == "$-")
-        {
-            if (From[posInFrom] == match.substr(2))
+        case pattern_backtrack:
+            if (From[posInFrom] == match.what)
             {
                 k--;
             }
-        }
+            break;
 
         // Negative lookbehind
         // Not prefixed by some literal
-        else if (match.size() > 4 && match.substr(0, 4) == "$/<$")
-        {
+        case pattern_not_prefixed:
             // PosInFrom does not advance upon success
-            if (posInFrom > 0 && From[posInFrom - 1] == match.substr(4))
+            if (posInFrom > 0 && From[posInFrom - 1] == match.what)
             {
                 isMatch = false;
-                break;
             }
-
-            continue;
-        }
+            break;
 
         // Negative lookahead
         // Not followed by some literal
-        else if (match.size() > 4 && match.substr(0, 4) == "$/>$")
-        {
+        case pattern_not_followed:
             // PosInFrom does not advance upon success
-            if (posInFrom + 1 < From.size() && From[posInFrom + 1] == match.substr(4))
+            if (posInFrom + 1 < From.size() && From[posInFrom + 1] == match.what)
             {
                 isMatch = false;
-                break;
             }
-
-            continue;
-        }
+            break;
 
         // Suite
         // $[$suite$of$cards$]
-        else if (match.size() > 3 && match.substr(0, 3) == "$[$")
-        {
+        case pattern_suite:
             // Matches any of the items within
-
-            int start, end;
-            end = 3;
-
-            while (end < match.size())
+            if (find(match.options.begin(), match.options.end(), From[posInFrom]) != match.options.end())
             {
-                // Advance end to the next dollar sign
-                start = end;
-                do
-                {
-                    end++;
-                } while (end < match.size() && match[end] != '$');
-
-                if (end >= match.size())
-                {
-                    isMatch = false;
-                    break;
-                }
-
-                // Do actual compare here
-                // If matches, isMatch. Otherwise, keep going.
-                if (match.substr(start, end - start) == From[posInFrom])
-                {
-                    posInFrom++;
-                    break;
-                }
+                posInFrom++;
+            }
+            else
+            {
+                isMatch = false;
             }
 
             memory.push_back(From[posInFrom]);
-        }
+            break;
 
         // Negated suite
         // $/[$negated$suite$of$cards$]
-        else if (match.size() > 4 && match.substr(0, 4) == "$/[$")
-        {
+        case pattern_negated_suite:
             // Matches anything but the items within
-
-            int start, end;
-            end = 4;
-
-            while (end < match.size())
+            if (find(match.options.begin(), match.options.end(), From[posInFrom]) != match.options.end())
             {
-                // Advance end to the next dollar sign
-                start = end;
-                do
-                {
-                    end++;
-                } while (end < match.size() && match[end] != '$');
-
-                if (end >= match.size())
-                {
-                    posInFrom++;
-                    break;
-                }
-
-                // Do actual compare here
-                // If matches, is not match. Otherwise, keep going.
-                if (match.substr(start, end - start) == From[posInFrom])
-                {
-                    isMatch = false;
-                    break;
-                }
+                isMatch = false;
+            }
+            else
+            {
+                posInFrom++;
             }
 
             memory.push_back(From[posInFrom]);
-        }
+            break;
 
         // $<$open$close$>
         // Pair matching
-        else if (match.size() > 7 && match.substr(0, 3) == "$<$")
-        {
-            int endOfOpener = 3;
-            while (endOfOpener < match.size() && match[endOfOpener] != '$')
-            {
-                endOfOpener++;
-            }
-
-            int endOfCloser = endOfOpener + 1;
-            while (endOfCloser < match.size() && match[endOfCloser] != '$')
-            {
-                endOfCloser++;
-            }
-
-            string opener = match.substr(3, endOfOpener - 3),
-                   closer = match.substr(endOfOpener + 1, endOfCloser - endOfOpener - 1);
+        case pattern_pair: {
             long long count = 0;
-
-            int beginningPosition = posInFrom;
+            size_t beginningPosition = posInFrom;
 
             do
             {
-                if (posInFrom > From.size())
+                memory.push_back(From[posInFrom]);
+
+                if (From[posInFrom] == match.what)
                 {
-                    // Out of range w/o closure: Failure case
-                    isMatch = false;
-                    break;
+                    count++;
                 }
-                else if (From[posInFrom].size() < 2 || From[posInFrom].substr(0, 2) != "//")
+                else if (From[posInFrom] == match.closer)
                 {
-                    memory.push_back(From[posInFrom]);
-
-                    if (From[posInFrom] == opener)
-                    {
-                        count++;
-                    }
-                    else if (From[posInFrom] == closer)
-                    {
-                        count--;
-                    }
+                    count--;
                 }
 
                 posInFrom++;
             } while (posInFrom < From.size() && count != 0);
 
-            if (!isMatch || posInFrom == beginningPosition || posInFrom == beginningPosition + 1)
+            if (posInFrom == beginningPosition + 1)
             {
                 isMatch = false;
-                break;
             }
 
-            continue;
+            break;
         }
 
         // Variable glob; Stored multi-symbol match
-        else if (match.size() == 3 && match.substr(0, 2) == "$*")
-        {
-            string name = match.substr(0, 1) + match.substr(2, 1);
-
+        case pattern_variable_glob: {
             throw_assert(k + 1 < curRule.inputPattern.size());
-            string nextSymb = curRule.inputPattern[k + 1];
+            const token &nextSymb = curRule.inputPattern[k + 1];
 
             while (posInFrom < From.size() && From[posInFrom] != nextSymb)
             {
-                if (ruleVars.count(name) == 0)
+                if (ruleVars.count(match.name) == 0)
                 {
-                    ruleVars[name] += From[posInFrom];
+                    ruleVars[match.name] += From[posInFrom];
                 }
                 else
                 {
-                    ruleVars[name] += " " + From[posInFrom];
+                    ruleVars[match.name] += " " + From[posInFrom];
                 }
 
                 memory.push_back(From[posInFrom]);
@@ -740,51 +781,48 @@ void doRuleAcorn(vector<string> &From, int &i, rule &curRule)
                     isMatch = false;
                     break;
                 }
-
-                while (From[posInFrom].size() > 1 && From[posInFrom].substr(0, 2) == "//")
-                {
-                    posInFrom++;
-                    if (posInFrom >= From.size())
-                    {
-                        isMatch = false;
-                        break;
-                    }
-                }
             }
 
-            continue;
+            break;
         }
 
         // Variable; Stored match
-        else if (match[0] == '$')
-        {
-            if (ruleVars.count(match) == 0)
+        case pattern_variable:
+            if (ruleVars.count(match.name) == 0)
             {
-                ruleVars[match] = From[posInFrom];
+                ruleVars[match.name] = From[posInFrom];
             }
             else
             {
-                ruleVars[match] += " " + From[posInFrom];
+                ruleVars[match.name] += " " + From[posInFrom];
             }
 
             memory.push_back(From[posInFrom]);
 
             posInFrom++;
-        }
+            break;
 
         // Literal; Must match verbatim
-        else if (match == From[posInFrom])
-        {
-            posInFrom++;
-            memory.push_back(From[posInFrom]);
+        case pattern_literal:
+            if (match.what == From[posInFrom])
+            {
+                posInFrom++;
 
-            continue;
+                if (posInFrom < From.size())
+                {
+                    memory.push_back(From[posInFrom]);
+                }
+            }
+            else
+            {
+                isMatch = false;
+            }
+            break;
         }
 
-        // Failure case
-        else
+        // Nothing after a failure can make this a match
+        if (!isMatch)
         {
-            isMatch = false;
             break;
         }
     }
@@ -794,17 +832,20 @@ void doRuleAcorn(vector<string> &From, int &i, rule &curRule)
     {
         // Variable table is already built at this point
 
+        // Output takes on the line of the first token matched
+        unsigned int line = From[i].line;
+
         // Get new contents
-        vector<string> newContents;
+        vector<token> newContents;
         for (int sIndex = 0; sIndex < curRule.outputPattern.size(); sIndex++)
         {
-            string s = curRule.outputPattern[sIndex];
+            const token &s = curRule.outputPattern[sIndex];
 
             if (ruleVars.count(s) != 0)
             {
                 string raw = ruleVars[s];
 
-                vector<string> lexed = lex(raw);
+                vector<token> lexed = lex(raw);
                 for (auto s : lexed)
                 {
                     newContents.push_back(s);
@@ -821,7 +862,7 @@ void doRuleAcorn(vector<string> &From, int &i, rule &curRule)
                 if (ruleVars.count(toInsert) != 0)
                 {
                     string raw = ruleVars[toInsert];
-                    vector<string> lexed = lex(raw);
+                    vector<token> lexed = lex(raw);
 
                     toInsert = "";
                     for (auto str : lexed)
@@ -835,7 +876,7 @@ void doRuleAcorn(vector<string> &From, int &i, rule &curRule)
                     sIndex++;
                 }
 
-                newContents.back().append(toInsert);
+                newContents.back() = newContents.back() + toInsert;
             }
             else
             {
@@ -864,7 +905,7 @@ void doRuleAcorn(vector<string> &From, int &i, rule &curRule)
         // }
 
         // Erase old contents
-        for (int k = i; k < posInFrom; k++)
+        for (size_t k = i; k < posInFrom; k++)
         {
             // if (doRuleLogFile)
             // {
@@ -878,7 +919,7 @@ void doRuleAcorn(vector<string> &From, int &i, rule &curRule)
             }
             else
             {
-                From.erase(From.begin() + i);
+                From.erase(i);
             }
         }
 
@@ -895,16 +936,17 @@ void doRuleAcorn(vector<string> &From, int &i, rule &curRule)
         // }
 
         // Insert new contents
-        for (int k = newContents.size() - 1; k >= 0; k--)
+        for (token &t : newContents)
         {
-            From.insert(From.begin() + i, newContents[k]);
+            t.line = line;
         }
+        From.insert(i, newContents);
     }
 
     ruleVars.clear();
 }
 
-void addEngine(const string &name, void (*hook)(vector<string> &, int &, rule &))
+void addEngine(const string &name, void (*hook)(tokenBuffer &, int &, rule &))
 {
     engines[name] = hook;
     return;
@@ -17,9 +17,11 @@ Defines preprocessor rules for Oak
 #include <map>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "lexer.hpp"
+#include "token_buffer.hpp"
 
 using namespace std;
 
@@ -35,20 +37,63 @@ class rule_error : public runtime_error
 #define rm_assert(expression, message)                                                                                 \
     ((bool)(expression) ? true : throw rule_error(message " (Failed assertion: '" #expression "')"))
 
+// The kinds of item which can appear in a Sapling input pattern
+enum patternItemKind : unsigned char
+{
+    pattern_literal,        // foo
+    pattern_variable,       // $a
+    pattern_wildcard,       // $$
+    pattern_glob,           // $*
+    pattern_plus_glob,      // $+
+    pattern_variable_glob,  // $*a
+    pattern_memory_clear,   // $~
+    pattern_memory_pipe,    // $>a
+    pattern_backtrack,      // $-foo
+    pattern_not_prefixed,   // $/<$foo
+    pattern_not_followed,   // $/>$foo
+    pattern_suite,          // $[$a$b$]
+    pattern_negated_suite,  // $/[$a$b$]
+    pattern_pair,           // $<$open$close$>
+};
+
+/*
+One input pattern token, parsed ahead of time so that
+matching never has to pick apart the pattern text.
+*/
+struct patternItem
+{
+    patternItemKind kind;
+
+    // The token to compare against; For pairs, the opener
+    token what;
+
+    // Pairs only
+    token closer;
+
+    // The rule variable this stores into, if any
+    string name;
+
+    // Suites only
+    vector<token> options;
+};
+
 struct rule
 {
-    vector<string> inputPattern;
-    vector<string> outputPattern;
+    vector<token> inputPattern;
+    vector<token> outputPattern;
+
+    // inputPattern, compiled by compileRule. One item per token.
+    vector<patternItem> compiled;
 
     // The function to call
-    void (*doRule)(vector<string> &, int &, rule &);
+    void (*doRule)(tokenBuffer &, int &, rule &);
 };
 
 // Maps a string engine ID to its corresponding engine function.
-extern map<string, void (*)(vector<string> &, int &, rule &)> engines;
+extern map<string, void (*)(tokenBuffer &, int &, rule &)> engines;
 
 // Add a new engine
-void addEngine(const string &name, void (*hook)(vector<string> &, int &, rule &));
+void addEngine(const string &name, void (*hook)(tokenBuffer &, int &, rule &));
 
 extern bool doRuleLogFile;
 extern map<string, rule> rules;
@@ -61,17 +106,20 @@ extern bool dialectLock;
 
 extern map<string, vector<string>> bundles;
 
+// Compiles the input pattern of a rule for the Sapling engine
+void compileRule(rule &What);
+
 // I is the point in Lexed at which a macro name was found
 // CONSUMPTIVE!
-vector<string> getMacroArgs(vector<string> &lexed, const int &i);
+vector<string> getMacroArgs(tokenBuffer &lexed, const int &i);
 
 // Active rules should already be present in their vector
-void doRules(vector<string> &From);
+void doRules(tokenBuffer &From);
 
 // Load a dialect file
 void loadDialectFile(const string &File);
 
 // Internal pass-through for Sapling rule engine
-void doRuleAcorn(vector<string> &tokens, int &i, rule &toDo);
+void doRuleAcorn(tokenBuffer &tokens, int &i, rule &toDo);
 
 #endif
@@ -11,7 +11,7 @@ GPLv3 held by author
 #include "symbol_table.hpp"
 #include "tags.hpp"
 
-vector<string> curLineSymbols;
+vector<token> curLineSymbols;
 
 unsigned long long int curLine = 1;
 string curFile = "";
@@ -19,48 +19,203 @@ string curFile = "";
 // The current depth of createSequence
 unsigned long long int depth = 0;
 
-// Internal consumptive version: Erases from vector, so not safe for frontend
-sequence __createSequence(list<string> &From);
+/*
+A read-only span of lexed tokens, consumed from the front by
+moving a cursor. Statements and arguments are read as subranges
+of the one lexed vector instead of being copied out. Tokens
+pushed to the front (as by type!) are kept aside and read first.
+*/
+class tokenCursor
+{
+  public:
+    tokenCursor(const vector<token> &From) : data(From.data()), pos(0), stop(From.size())
+    {
+    }
+
+    tokenCursor(const token *Data, const size_t &Begin, const size_t &End) : data(Data), pos(Begin), stop(End)
+    {
+    }
+
+    bool empty() const
+    {
+        return pushed.empty() && pos >= stop;
+    }
+
+    size_t size() const
+    {
+        return pushed.size() + (stop - pos);
+    }
+
+    const token &front() const
+    {
+        static const token none;
+
+        if (!pushed.empty())
+        {
+            return pushed.back();
+        }
+
+        return pos < stop ? data[pos] : none;
+    }
+
+    void pop_front()
+    {
+        if (!pushed.empty())
+        {
+            pushed.pop_back();
+        }
+        else if (pos < stop)
+        {
+            pos++;
+        }
+
+        return;
+    }
+
+    void push_front(const token &What)
+    {
+        pushed.push_back(What);
+        return;
+    }
+
+    // The position of the cursor in the underlying tokens
+    size_t position() const
+    {
+        return pos;
+    }
+
+    // The tokens between two positions, as a new cursor. Nothing
+    // may have been pushed to the front.
+    tokenCursor range(const size_t &Begin, const size_t &End) const
+    {
+        parse_assert(pushed.empty());
+        return tokenCursor(data, Begin, End);
+    }
+
+    const token &operator[](const size_t &Index) const
+    {
+        return Index < pushed.size() ? pushed[pushed.size() - 1 - Index] : data[pos + Index - pushed.size()];
+    }
+
+    // Read-only forward iteration over what remains
+    class const_iterator
+    {
+      public:
+        const_iterator(const tokenCursor *Cursor, const size_t &Index) : cursor(Cursor), index(Index)
+        {
+        }
+
+        const token &operator*() const
+        {
+            return (*cursor)[index];
+        }
+        const token *operator->() const
+        {
+            return &(*cursor)[index];
+        }
+        const_iterator &operator++()
+        {
+            index++;
+            return *this;
+        }
+        bool operator!=(const const_iterator &Other) const
+        {
+            return index != Other.index;
+        }
+
+      protected:
+        const tokenCursor *cursor;
+        size_t index;
+    };
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+    const_iterator end() const
+    {
+        return const_iterator(this, size());
+    }
+
+  protected:
+    const token *data;
+    size_t pos, stop;
+    vector<token> pushed;
+};
+
+// Internal consumptive version: Advances the cursor past what it reads
+sequence __createSequence(tokenCursor &From);
+
+// Pops a parenthesized argument list from the front of From,
+// returning what was within the outermost parentheses
+static tokenCursor popArguments(tokenCursor &From)
+{
+    size_t start = From.position(), end = start;
+    int count = 0;
 
-sequence createSequence(const vector<string> &From)
+    do
+    {
+        end = From.position() + 1;
+
+        if (From.front() == tok::lparen)
+        {
+            count++;
+
+            // The opening parenthesis is not an argument
+            if (count == 1)
+            {
+                start = end;
+            }
+        }
+        else if (From.front() == tok::rparen)
+        {
+            count--;
+
+            // Nor is the closing one
+            if (count == 0)
+            {
+                end--;
+            }
+        }
+
+        sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
+        From.pop_front();
+    } while (!From.empty() && count != 0);
+
+    return From.range(start, end);
+}
+
+sequence createSequence(const vector<token> &From)
 {
-    // Clone to feed into the consumptive version
-    // vector<string> temp(From);
-    list<string> temp;
-    temp.assign(From.begin(), From.end());
+    // The consumptive version only moves a cursor over From
+    tokenCursor temp(From);
 
-    vector<sequence> out;
+    sequence out;
 
     // Feed to consumptive version
     while (!temp.empty())
     {
-        out.push_back(__createSequence(temp));
+        out.items.push_back(__createSequence(temp));
     }
 
-    if (out.size() == 0)
+    if (out.items.size() == 0)
     {
         return sequence{};
     }
-    else if (out.size() == 1)
+    else if (out.items.size() == 1)
     {
-        return out[0];
+        return move(out.items[0]);
     }
     else
     {
-        sequence outSeq;
-        outSeq.info = code_scope;
-        outSeq.type = nullType;
-
-        for (auto i : out)
-        {
-            outSeq.items.push_back(i);
-        }
-        return outSeq;
+        out.info = code_scope;
+        out.type = nullType;
+        return out;
     }
 }
 
-// Internal consumptive version: Erases from vector, so not safe for frontend
-sequence __createSequence(list<string> &From)
+// Internal consumptive version: Advances the cursor past what it reads
+sequence __createSequence(tokenCursor &From)
 {
     static string prevMatchTypeStr = "NULL";
 
@@ -72,34 +227,20 @@ sequence __createSequence(list<string> &From)
     {
         return out;
     }
-    else if (strncmp(From.front().c_str(), "//__LINE__=", 11) == 0)
-    {
-        // Line update special symbol
-        string newLineNum = From.front().substr(11);
 
-        curLine = stoull(newLineNum);
+    // Update line info from the first token
+    if (From.front().line != 0 && From.front().line != curLine)
+    {
+        curLine = From.front().line;
 
         curLineSymbols.clear();
-        if (From.size() != 0)
-        {
-            for (auto it = From.begin();
-                 it != From.end() && !(it != From.begin() && it->size() > 11 && it->substr(0, 11) == "//__LINE__=");
-                 it++)
-            {
-                curLineSymbols.push_back(*it);
-            }
-        }
-
-        if (curLineSymbols.size() != 0)
+        for (auto it = From.begin(); it != From.end() && it->line == curLine; ++it)
         {
-            curLineSymbols.erase(curLineSymbols.begin());
+            curLineSymbols.push_back(*it);
         }
-
-        sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
-        From.pop_front();
-        return __createSequence(From);
     }
-    else if (From.front() == ",")
+
+    if (From.front() == tok::comma)
     {
         return out;
     }
@@ -108,27 +249,27 @@ sequence __createSequence(list<string> &From)
     {
         // Erasure macro; Erases types or struct members from existence
         // Technically just marks them erased
-        if (From.front() == "erase!")
+        if (From.front() == tok::erase_macro)
         {
             int count = 0;
             sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
             From.pop_front();
-            list<string> contents;
+            vector<token> contents;
 
             do
             {
-                if (From.front() == "(")
+                if (From.front() == tok::lparen)
                 {
                     count++;
                 }
-                else if (From.front() == ")")
+                else if (From.front() == tok::rparen)
                 {
                     count--;
                 }
 
-                if (!(count == 1 && From.front() == "(") && !(count == 0 && From.front() == ")"))
+                if (!(count == 1 && From.front() == tok::lparen) && !(count == 0 && From.front() == tok::rparen))
                 {
-                    if (From.front() != ",")
+                    if (From.front() != tok::comma)
                     {
                         contents.push_back(From.front());
                     }
@@ -170,7 +311,7 @@ sequence __createSequence(list<string> &From)
         }
 
         // Misc macros
-        else if (From.front() == "c_print!")
+        else if (From.front() == tok::c_print_macro)
         {
             cout << curFile << ":" << curLine << ":c_print! ";
 
@@ -180,23 +321,20 @@ sequence __createSequence(list<string> &From)
 
             do
             {
-                if (From.front() == "(")
+                if (From.front() == tok::lparen)
                 {
                     count++;
                 }
-                else if (From.front() == ")")
+                else if (From.front() == tok::rparen)
                 {
                     count--;
                 }
 
-                if (strncmp(From.front().c_str(), "//", 2) != 0)
+                if (!(count == 1 && From.front() == tok::lparen) && !(count == 0 && From.front() == tok::rparen) &&
+                    From.front() != tok::comma)
                 {
-                    if (!(count == 1 && From.front() == "(") && !(count == 0 && From.front() == ")") &&
-                        From.front() != ",")
-                    {
-                        string cur = From.front();
-                        cout << cleanMacroArgument(cur) << " ";
-                    }
+                    string cur = From.front();
+                    cout << cleanMacroArgument(cur) << " ";
                 }
 
                 sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
@@ -208,7 +346,7 @@ sequence __createSequence(list<string> &From)
 
             return out;
         }
-        else if (From.front() == "c_panic!")
+        else if (From.front() == tok::c_panic_macro)
         {
             string message = curFile + ":" + to_string(curLine) + ":c_panic! ";
 
@@ -218,22 +356,19 @@ sequence __createSequence(list<string> &From)
 
             do
             {
-                if (From.front() == "(")
+                if (From.front() == tok::lparen)
                 {
                     count++;
                 }
-                else if (From.front() == ")")
+                else if (From.front() == tok::rparen)
                 {
                     count--;
                 }
 
-                if (strncmp(From.front().c_str(), "//", 2) != 0)
+                if (!(count == 1 && From.front() == tok::lparen) && !(count == 0 && From.front() == tok::rparen) &&
+                    From.front() != tok::comma)
                 {
-                    if (!(count == 1 && From.front() == "(") && !(count == 0 && From.front() == ")") &&
-                        From.front() != ",")
-                    {
-                        message += cleanMacroArgument(From.front()) + " ";
-                    }
+                    message += cleanMacroArgument(From.front()) + " ";
                 }
 
                 sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
@@ -244,7 +379,7 @@ sequence __createSequence(list<string> &From)
 
             throw sequencing_error(message);
         }
-        else if (From.front() == "c_sys!")
+        else if (From.front() == tok::c_sys_macro)
         {
             cout << curFile << ":" << to_string(curLine) << ":c_sys! ";
 
@@ -255,19 +390,19 @@ sequence __createSequence(list<string> &From)
 
             do
             {
-                if (From.front() == "(")
+                if (From.front() == tok::lparen)
                 {
                     count++;
                 }
-                else if (From.front() == ")")
+                else if (From.front() == tok::rparen)
                 {
                     count--;
                 }
 
                 if (From.front().size() > 2 && strncmp(From.front().c_str(), "//", 2) != 0)
                 {
-                    if (!(count == 1 && From.front() == "(") && !(count == 0 && From.front() == ")") &&
-                        From.front() != ",")
+                    if (!(count == 1 && From.front() == tok::lparen) && !(count == 0 && From.front() == tok::rparen) &&
+                        From.front() != tok::comma)
                     {
                         if (command != "")
                         {
@@ -296,39 +431,18 @@ sequence __createSequence(list<string> &From)
         // else
 
         // Memory Keywords
-        else if (From.front() == "alloc!")
+        else if (From.front() == tok::alloc_macro)
         {
-            int count = 0;
             sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
             From.pop_front();
-            list<string> contents;
-
-            do
-            {
-                if (From.front() == "(")
-                {
-                    count++;
-                }
-                else if (From.front() == ")")
-                {
-                    count--;
-                }
-
-                if (!(count == 1 && From.front() == "(") && !(count == 0 && From.front() == ")"))
-                {
-                    contents.push_back(From.front());
-                }
-
-                sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
-                From.pop_front();
-            } while (!From.empty() && count != 0);
+            tokenCursor contents = popArguments(From);
 
             string num = "1";
 
             sequence temp = __createSequence(contents);
             string name = toC(temp);
 
-            while (contents.front() == ",")
+            while (!contents.empty() && contents.front() == tok::comma)
             {
                 contents.pop_front();
             }
@@ -359,32 +473,11 @@ sequence __createSequence(list<string> &From)
 
             return out;
         }
-        else if (From.front() == "free!")
+        else if (From.front() == tok::free_macro)
         {
-            int count = 0;
             sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
             From.pop_front();
-            list<string> contents;
-
-            do
-            {
-                if (From.front() == "(")
-                {
-                    count++;
-                }
-                else if (From.front() == ")")
-                {
-                    count--;
-                }
-
-                if (!(count == 1 && From.front() == "(") && !(count == 0 && From.front() == ")"))
-                {
-                    contents.push_back(From.front());
-                }
-
-                sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
-                From.pop_front();
-            } while (!From.empty() && count != 0);
+            tokenCursor contents = popArguments(From);
 
             sequence temp = __createSequence(contents);
             string name = toC(temp);
@@ -398,37 +491,16 @@ sequence __createSequence(list<string> &From)
 
             return out;
         }
-        else if (From.front() == "ptrcpy!")
+        else if (From.front() == tok::ptrcpy_macro)
         {
-            int count = 0;
             sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
             From.pop_front();
-            list<string> contents;
-
-            do
-            {
-                if (From.front() == "(")
-                {
-                    count++;
-                }
-                else if (From.front() == ")")
-                {
-                    count--;
-                }
-
-                if (!(count == 1 && From.front() == "(") && !(count == 0 && From.front() == ")"))
-                {
-                    contents.push_back(From.front());
-                }
-
-                sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
-                From.pop_front();
-            } while (!From.empty() && count != 0);
+            tokenCursor contents = popArguments(From);
 
             sequence lhsSeq = __createSequence(contents);
             string lhs = toC(lhsSeq);
 
-            while (contents.front() == ",")
+            while (!contents.empty() && contents.front() == tok::comma)
             {
                 contents.pop_front();
             }
@@ -445,41 +517,20 @@ sequence __createSequence(list<string> &From)
             out.type = nullType;
             out.items.clear();
 
-            out.items.push_back(sequence{nullType, vector<sequence>(), atom, lhs + " = (void*)(" + rhs + ")"});
+            out.items.push_back(sequence{nullType, {}, atom, lhs + " = (void*)(" + rhs + ")"});
 
             return out;
         }
-        else if (From.front() == "ptrarr!")
+        else if (From.front() == tok::ptrarr_macro)
         {
-            int count = 0;
             sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
             From.pop_front();
-            list<string> contents;
-
-            do
-            {
-                if (From.front() == "(")
-                {
-                    count++;
-                }
-                else if (From.front() == ")")
-                {
-                    count--;
-                }
-
-                if (!(count == 1 && From.front() == "(") && !(count == 0 && From.front() == ")"))
-                {
-                    contents.push_back(From.front());
-                }
-
-                sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
-                From.pop_front();
-            } while (!From.empty() && count != 0);
+            tokenCursor contents = popArguments(From);
 
             sequence lhsSeq = __createSequence(contents);
             string lhs = toC(lhsSeq);
 
-            while (contents.front() == ",")
+            while (!contents.empty() && contents.front() == tok::comma)
             {
                 contents.pop_front();
             }
@@ -508,7 +559,7 @@ sequence __createSequence(list<string> &From)
     } // Macros
 
     // Misc key-characters
-    else if (From.front() == ";")
+    else if (From.front() == tok::semicolon)
     {
         sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
         From.pop_front();
@@ -521,7 +572,7 @@ sequence __createSequence(list<string> &From)
     // Keywords below
 
     // Enums- VERY C dependant!
-    else if (From.front() == "match")
+    else if (From.front() == tok::match_kw)
     {
         // Takes an enum code line and a code scope / code line
         out.info = enum_keyword;
@@ -569,7 +620,7 @@ sequence __createSequence(list<string> &From)
 
         return out;
     }
-    else if (From.front() == "case")
+    else if (From.front() == tok::case_kw)
     {
         // case NAME() {}
         sm_assert(prevMatchTypeStr != "NULL", "'case' statement must occur within a 'match' statement.");
@@ -583,13 +634,13 @@ sequence __createSequence(list<string> &From)
         From.pop_front();
 
         sm_assert(!From.empty(), "'case' must be followed by enumeration option name.");
-        out.items.push_back(sequence{nullType, vector<sequence>{}, atom, From.front()});
+        out.items.push_back(sequence{nullType, {}, atom, From.front()});
         string optionName = From.front();
 
         sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
         From.pop_front();
 
-        sm_assert(!From.empty() && From.front() == "(",
+        sm_assert(!From.empty() && From.front() == tok::lparen,
                   "Enumeration option must be followed by capture parenthesis (IE name(capture_here)).");
         sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
         From.pop_front();
@@ -597,22 +648,23 @@ sequence __createSequence(list<string> &From)
         sm_assert(!From.empty(), "Capture group is missing name or closing parenthesis.");
         string captureName = "NULL";
 
-        if (From.front() != ")")
+        if (From.front() != tok::rparen)
         {
             captureName = From.front();
-            out.items.push_back(sequence{nullType, vector<sequence>{}, atom, From.front()});
+            out.items.push_back(sequence{nullType, {}, atom, From.front()});
             From.pop_front();
 
-            table[captureName].push_back(__multiTableSymbol{sequence{}, pointer, false, curFile});
+            saveSymbols(captureName);
+            table[captureName].push_back(__multiTableSymbol{newBody(), pointer, false, curFile});
             table[captureName].back().type.append(enumData[prevMatchTypeStr].options[optionName]);
         }
         else
         {
             // Padding so that this spot will always refer to the capture variable
-            out.items.push_back(sequence{nullType, vector<sequence>{}, atom, "NULL"});
+            out.items.push_back(sequence{nullType, {}, atom, "NULL"});
         }
 
-        sm_assert(!From.empty() && From.front() == ")", "Capture parenthesis must contain at most one symbol.");
+        sm_assert(!From.empty() && From.front() == tok::rparen, "Capture parenthesis must contain at most one symbol.");
 
         sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
         From.pop_front();
@@ -628,7 +680,7 @@ sequence __createSequence(list<string> &From)
 
         return out;
     }
-    else if (From.front() == "default")
+    else if (From.front() == tok::default_kw)
     {
         // default {}
 
@@ -646,7 +698,7 @@ sequence __createSequence(list<string> &From)
     }
 
     // Conditionals and junk
-    else if (From.front() == "if" || From.front() == "while")
+    else if (From.front() == tok::if_kw || From.front() == tok::while_kw)
     {
         // Takes a bool code line and a code scope / code line
         out.info = keyword;
@@ -673,12 +725,12 @@ sequence __createSequence(list<string> &From)
         }
         else if (out.items.back().info == code_line)
         {
-            out.items.back().items.push_back(sequence{nullType, vector<sequence>(), atom, ";"});
+            out.items.back().items.push_back(sequence{nullType, {}, atom, ";"});
         }
 
         return out;
     }
-    else if (From.front() == "else")
+    else if (From.front() == tok::else_kw)
     {
         // Takes a code scope / code line
         out.info = keyword;
@@ -692,12 +744,12 @@ sequence __createSequence(list<string> &From)
 
         return out;
     }
-    else if (From.front() == "return")
+    else if (From.front() == tok::return_kw)
     {
         // Takes a code scope / code line
         out.info = code_line;
         out.type = nullType;
-        out.items.push_back(sequence{nullType, vector<sequence>(), atom, "return"});
+        out.items.push_back(sequence{nullType, {}, atom, "return"});
 
         sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
         From.pop_front();
@@ -706,7 +758,7 @@ sequence __createSequence(list<string> &From)
 
         return out;
     }
-    else if (From.front() == "let")
+    else if (From.front() == tok::let_kw)
     {
         // Get name
         sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
@@ -718,29 +770,29 @@ sequence __createSequence(list<string> &From)
         From.pop_front();
 
         // Gather templating if there is any
-        vector<string> generics;
-        if (From.front() == "<")
+        vector<token> generics;
+        if (From.front() == tok::langle)
         {
             int count = 0;
 
             do
             {
-                if (From.front() == "<")
+                if (From.front() == tok::langle)
                 {
                     count++;
                 }
-                else if (From.front() == ">")
+                else if (From.front() == tok::rangle)
                 {
                     count--;
                 }
 
-                if (From.front() != "<" || count != 1)
+                if (From.front() != tok::langle || count != 1)
                 {
                     generics.push_back(From.front());
                 }
 
                 From.pop_front();
-            } while (!From.empty() && !(count == 1 && From.front() == ">"));
+            } while (!From.empty() && !(count == 1 && From.front() == tok::rangle));
 
             // Trim trailing angle bracket
             if (!From.empty())
@@ -750,17 +802,17 @@ sequence __createSequence(list<string> &From)
         }
 
         // Get type
-        if (From.front() == ":")
+        if (From.front() == tok::colon)
         {
             sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
             From.pop_front();
 
-            if (!From.empty() && (From.front() == "struct" || From.front() == "enum"))
+            if (!From.empty() && (From.front() == tok::struct_kw || From.front() == tok::enum_kw))
             {
                 // addStruct takes in the full struct definition, from
                 // let to end curly bracket. So we must first parse this.
 
-                vector<string> toAdd = {"let", name};
+                vector<token> toAdd = {"let", name};
 
                 // Add generics back in here
                 if (generics.size() != 0)
@@ -777,7 +829,7 @@ sequence __createSequence(list<string> &From)
                 string front = From.front();
 
                 int count = 0;
-                while (count != 0 || (!From.empty() && From.front() != "}" && From.front() != ";"))
+                while (count != 0 || (!From.empty() && From.front() != tok::rbrace && From.front() != tok::semicolon))
                 {
                     toAdd.push_back(From.front());
 
@@ -818,37 +870,27 @@ sequence __createSequence(list<string> &From)
                 else
                 {
                     // Check for needs / inst block here
-                    vector<string> preBlock, postBlock;
-
-                    while (!From.empty() && From.front().size() > 1 && From.front().substr(0, 2) == "//")
-                    {
-                        From.pop_front();
-                    }
+                    vector<token> preBlock, postBlock;
 
-                    while (!From.empty() && (From.front() == "pre" || From.front() == "post"))
+                    while (!From.empty() && (From.front() == tok::pre_kw || From.front() == tok::post_kw))
                     {
-                        if (!From.empty() && From.front() == "pre")
+                        if (!From.empty() && From.front() == tok::pre_kw)
                         {
                             // pop needs
                             From.pop_front();
 
-                            while (!From.empty() && From.front().size() > 1 && From.front().substr(0, 2) == "//")
-                            {
-                                From.pop_front();
-                            }
-
                             // pop {
-                            sm_assert(!From.empty() && From.front() == "{", "'pre' block must be followed by scope.");
+                            sm_assert(!From.empty() && From.front() == tok::lbrace, "'pre' block must be followed by scope.");
                             From.pop_front();
 
                             int count = 1;
                             while (!From.empty())
                             {
-                                if (From.front() == "{")
+                                if (From.front() == tok::lbrace)
                                 {
                                     count++;
                                 }
-                                else if (From.front() == "}")
+                                else if (From.front() == tok::rbrace)
                                 {
                                     count--;
                                 }
@@ -865,28 +907,23 @@ sequence __createSequence(list<string> &From)
                                 }
                             }
                         }
-                        else if (!From.empty() && From.front() == "post")
+                        else if (!From.empty() && From.front() == tok::post_kw)
                         {
                             // pop needs
                             From.pop_front();
 
-                            while (!From.empty() && From.front().size() > 1 && From.front().substr(0, 2) == "//")
-                            {
-                                From.pop_front();
-                            }
-
                             // pop {
-                            sm_assert(!From.empty() && From.front() == "{", "'post' block must be followed by scope.");
+                            sm_assert(!From.empty() && From.front() == tok::lbrace, "'post' block must be followed by scope.");
                             From.pop_front();
 
                             int count = 1;
                             while (!From.empty())
                             {
-                                if (From.front() == "{")
+                                if (From.front() == tok::lbrace)
                                 {
                                     count++;
                                 }
-                                else if (From.front() == "}")
+                                else if (From.front() == tok::rbrace)
                                 {
                                     count--;
                                 }
@@ -903,11 +940,6 @@ sequence __createSequence(list<string> &From)
                                 }
                             }
                         }
-
-                        while (!From.empty() && From.front().size() > 1 && From.front().substr(0, 2) == "//")
-                        {
-                            From.pop_front();
-                        }
                     }
 
                     addGeneric(toAdd, name, generics, {front}, preBlock, postBlock);
@@ -924,35 +956,35 @@ sequence __createSequence(list<string> &From)
                 sm_assert(generics.empty(), "Variable declaration must not be templated.");
 
                 // Scrape entire definition for this
-                vector<string> toAdd = {
+                vector<token> toAdd = {
                     "let",
                     name,
                     ":",
                 };
 
-                while (!From.empty() && From.front() != ";")
+                while (!From.empty() && From.front() != tok::semicolon)
                 {
-                    if (From.front() == "type!")
+                    if (From.front() == tok::type_macro)
                     {
                         // Case for type!() macro
 
                         // Scrape entire type!(what) call to a vector
-                        vector<string> toAnalyze;
+                        vector<token> toAnalyze;
                         int count = 0;
 
                         From.pop_front();
                         do
                         {
-                            if (From.front() == "(")
+                            if (From.front() == tok::lparen)
                             {
                                 count++;
                             }
-                            else if (From.front() == ")")
+                            else if (From.front() == tok::rparen)
                             {
                                 count--;
                             }
 
-                            if (!((From.front() == "(" && count == 1) || (From.front() == ")" && count == 0)))
+                            if (!((From.front() == tok::lparen && count == 1) || (From.front() == tok::rparen && count == 0)))
                             {
                                 toAnalyze.push_back(From.front());
                             }
@@ -968,7 +1000,7 @@ sequence __createSequence(list<string> &From)
                         Type type = resolveFunction(toAnalyze, pos, junk);
 
                         // Convert type to lexed string vec
-                        vector<string> lexedType = lex(toStr(&type));
+                        vector<token> lexedType = lex(toStr(&type));
 
                         // Push lexed vec to front of From
                         for (auto iter = lexedType.rbegin(); iter != lexedType.rend(); iter++)
@@ -983,7 +1015,7 @@ sequence __createSequence(list<string> &From)
                     sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
                     From.pop_front();
 
-                    if (!From.empty() && From.front() == "=")
+                    if (!From.empty() && From.front() == tok::assign)
                     {
                         throw sequencing_error("Instantiate / assignment combo is not supported.");
                     }
@@ -997,38 +1029,39 @@ sequence __createSequence(list<string> &From)
 
                 Type type = toType(toAdd);
 
-                out.items.push_back(sequence{nullType, vector<sequence>(), atom, toStrC(&type, name)});
+                out.items.push_back(sequence{nullType, {}, atom, toStrC(&type, name)});
 
                 // Insert into table
+                saveSymbols(name);
                 table[name].push_back(
-                    __multiTableSymbol{sequence{type, vector<sequence>(), atom, ""}, type, false, curFile});
+                    __multiTableSymbol{newBody(sequence{type, {}, atom, ""}), type, false, curFile});
 
                 // Call constructor (pointers do not get constructors)
                 if (type[0].info != pointer && type[0].info != arr && type[0].info != sarr)
                 {
                     // Syntactically necessary
-                    out.items.push_back(sequence{nullType, vector<sequence>(), atom, ";"});
+                    out.items.push_back(sequence{nullType, {}, atom, ";"});
 
-                    vector<string> newCall = {"New", "(", "@", name, ")"};
+                    vector<token> newCall = {"New", "(", "@", name, ")"};
                     int garbage = 0;
 
                     sequence toAppend;
                     toAppend.info = atom;
                     toAppend.type = resolveFunction(newCall, garbage, toAppend.raw);
 
-                    out.items.push_back(toAppend);
+                    out.items.push_back(move(toAppend));
                 }
                 else if (type[0].info != sarr)
                 {
                     // Syntactically necessary
-                    out.items.push_back(sequence{nullType, vector<sequence>(), atom, ";"});
+                    out.items.push_back(sequence{nullType, {}, atom, ";"});
 
                     sequence toAppend;
                     toAppend.info = atom;
                     toAppend.type = nullType;
                     toAppend.raw = name + " = 0";
 
-                    out.items.push_back(toAppend);
+                    out.items.push_back(move(toAppend));
                 }
                 else
                 {
@@ -1036,7 +1069,7 @@ sequence __createSequence(list<string> &From)
                     // Set every byte inside to zero
 
                     // Syntactically necessary
-                    out.items.push_back(sequence{nullType, vector<sequence>(), atom, ";"});
+                    out.items.push_back(sequence{nullType, {}, atom, ";"});
 
                     sequence toAppend;
                     toAppend.info = atom;
@@ -1044,34 +1077,35 @@ sequence __createSequence(list<string> &From)
 
                     toAppend.raw = "for (i32 _i = 0; _i < sizeof(" + name + "); _i++) ((u8 *)(&" + name + "))[_i] = 0;";
 
-                    out.items.push_back(toAppend);
+                    out.items.push_back(move(toAppend));
                 }
 
                 return out;
             }
         }
-        else if (From.front() == "(")
+        else if (From.front() == tok::lparen)
         {
             // Function definition
             if (generics.size() == 0)
             {
                 // Arguments
-                vector<string> toAdd;
+                vector<token> toAdd;
                 do
                 {
                     toAdd.push_back(From.front());
                     sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
                     From.pop_front();
-                } while (From.front() != "{" && From.front() != ";");
+                } while (From.front() != tok::lbrace && From.front() != tok::semicolon);
 
                 auto type = toType(toAdd);
 
-                auto oldTable = table;
+                size_t argScope = openScope();
 
                 auto argsWithType = getArgs(type);
                 for (pair<string, Type> p : argsWithType)
                 {
-                    table[p.first].push_back(__multiTableSymbol{sequence(), p.second, false, curFile});
+                    saveSymbols(p.first);
+                    table[p.first].push_back(__multiTableSymbol{newBody(), p.second, false, curFile});
                 }
 
                 bool isSingleArg = true;
@@ -1102,7 +1136,7 @@ sequence __createSequence(list<string> &From)
                 }
 
                 // Insert explicit symbol
-                if (From.size() > 0 && From.front() == "{")
+                if (From.size() > 0 && From.front() == tok::lbrace)
                 {
                     if (name == "main")
                     {
@@ -1121,7 +1155,7 @@ sequence __createSequence(list<string> &From)
 
                     destroyUnits(name, type, true);
 
-                    table[name].push_back(__multiTableSymbol{sequence{}, type, false, curFile});
+                    table[name].push_back(__multiTableSymbol{newBody(), type, false, curFile});
 
                     if (name == "New")
                     {
@@ -1141,19 +1175,19 @@ sequence __createSequence(list<string> &From)
                         for (auto var : structData[structName].members)
                         {
                             // Add semicolon
-                            table["New"].back().seq.items.push_back(sequence{nullType, vector<sequence>(), atom, ";"});
+                            table["New"].back().seq->items.push_back(sequence{nullType, {}, atom, ";"});
 
                             sequence toAppend;
                             toAppend.info = atom;
                             toAppend.type = nullType;
                             toAppend.raw = getMemberNew("(*" + argsWithType[0].first + ")", var.first, var.second);
 
-                            table["New"].back().seq.items.push_back(toAppend);
+                            table["New"].back().seq->items.push_back(move(toAppend));
                         }
                     }
 
                     depth++;
-                    table[name].back().seq = __createSequence(From);
+                    *table[name].back().seq = __createSequence(From);
                     depth--;
 
                     if (name == "Del")
@@ -1174,14 +1208,14 @@ sequence __createSequence(list<string> &From)
                         for (auto var : structData[structName].members)
                         {
                             // Add semicolon
-                            table["Del"].back().seq.items.push_back(sequence{nullType, vector<sequence>(), atom, ";"});
+                            table["Del"].back().seq->items.push_back(sequence{nullType, {}, atom, ";"});
 
                             sequence toAppend;
                             toAppend.info = atom;
                             toAppend.type = nullType;
                             toAppend.raw = getMemberDel("(*" + argsWithType[0].first + ")", var.first, var.second);
 
-                            table["Del"].back().seq.items.push_back(toAppend);
+                            table["Del"].back().seq->items.push_back(move(toAppend));
                         }
                     }
                 }
@@ -1195,26 +1229,22 @@ sequence __createSequence(list<string> &From)
                     destroyUnits(name, type, false);
 
                     // Ensure exactly one unit declaration
-                    table[name].push_back(__multiTableSymbol{sequence{}, type, false, curFile});
+                    table[name].push_back(__multiTableSymbol{newBody(), type, false, curFile});
                 }
 
-                restoreSymbolTable(oldTable);
+                restoreSymbolTable(argScope);
             }
             else
             {
                 // Templated function definition
 
-                vector<string> toAdd = {"let", name}, returnType;
-                vector<string> typeVec;
+                vector<token> toAdd = {"let", name}, returnType;
+                vector<token> typeVec;
 
-                while (From.front() != "->")
+                while (From.front() != tok::arrow)
                 {
-                    if (From.front().size() < 2 || From.front().substr(0, 2) != "//")
-                    {
-                        typeVec.push_back(From.front());
-                        toAdd.push_back(From.front());
-                    }
-
+                    typeVec.push_back(From.front());
+                    toAdd.push_back(From.front());
                     From.pop_front();
                 }
 
@@ -1222,29 +1252,24 @@ sequence __createSequence(list<string> &From)
 
                 From.pop_front();
 
-                while (From.front() != "{" && From.front() != ";")
+                while (From.front() != tok::lbrace && From.front() != tok::semicolon)
                 {
-                    if (From.front().size() < 2 || From.front().substr(0, 2) != "//")
-                    {
-                        toAdd.push_back(From.front());
-
-                        returnType.push_back(From.front());
-                    }
-
+                    toAdd.push_back(From.front());
+                    returnType.push_back(From.front());
                     From.pop_front();
                 }
 
-                sm_assert(From.front() == "{", "Generic functions must be defined at declaration.");
+                sm_assert(From.front() == tok::lbrace, "Generic functions must be defined at declaration.");
 
                 // Scrape contents
                 int count = 0;
                 do
                 {
-                    if (From.front() == "{")
+                    if (From.front() == tok::lbrace)
                     {
                         count++;
                     }
-                    else if (From.front() == "}")
+                    else if (From.front() == tok::rbrace)
                     {
                         count--;
                     }
@@ -1255,37 +1280,27 @@ sequence __createSequence(list<string> &From)
                 } while (count != 0);
 
                 // Check for needs / inst block here
-                vector<string> preBlock, postBlock;
-
-                while (!From.empty() && From.front().size() > 1 && From.front().substr(0, 2) == "//")
-                {
-                    From.pop_front();
-                }
+                vector<token> preBlock, postBlock;
 
-                while (!From.empty() && (From.front() == "pre" || From.front() == "post"))
+                while (!From.empty() && (From.front() == tok::pre_kw || From.front() == tok::post_kw))
                 {
-                    if (!From.empty() && From.front() == "pre")
+                    if (!From.empty() && From.front() == tok::pre_kw)
                     {
                         // pop needs
                         From.pop_front();
 
-                        while (!From.empty() && From.front().size() > 1 && From.front().substr(0, 2) == "//")
-                        {
-                            From.pop_front();
-                        }
-
                         // pop {
-                        sm_assert(!From.empty() && From.front() == "{", "'pre' block must be followed by scope.");
+                        sm_assert(!From.empty() && From.front() == tok::lbrace, "'pre' block must be followed by scope.");
                         From.pop_front();
 
                         int count = 1;
                         while (!From.empty())
                         {
-                            if (From.front() == "{")
+                            if (From.front() == tok::lbrace)
                             {
                                 count++;
                             }
-                            else if (From.front() == "}")
+                            else if (From.front() == tok::rbrace)
                             {
                                 count--;
                             }
@@ -1302,28 +1317,23 @@ sequence __createSequence(list<string> &From)
                             }
                         }
                     }
-                    else if (!From.empty() && From.front() == "post")
+                    else if (!From.empty() && From.front() == tok::post_kw)
                     {
                         // pop needs
                         From.pop_front();
 
-                        while (!From.empty() && From.front().size() > 1 && From.front().substr(0, 2) == "//")
-                        {
-                            From.pop_front();
-                        }
-
                         // pop {
-                        sm_assert(!From.empty() && From.front() == "{", "'post' block must be followed by scope.");
+                        sm_assert(!From.empty() && From.front() == tok::lbrace, "'post' block must be followed by scope.");
                         From.pop_front();
 
                         int count = 1;
                         while (!From.empty())
                         {
-                            if (From.front() == "{")
+                            if (From.front() == tok::lbrace)
                             {
                                 count++;
                             }
-                            else if (From.front() == "}")
+                            else if (From.front() == tok::rbrace)
                             {
                                 count--;
                             }
@@ -1340,11 +1350,6 @@ sequence __createSequence(list<string> &From)
                             }
                         }
                     }
-
-                    while (!From.empty() && From.front().size() > 1 && From.front().substr(0, 2) == "//")
-                    {
-                        From.pop_front();
-                    }
                 }
 
                 // Insert templated function
@@ -1356,19 +1361,20 @@ sequence __createSequence(list<string> &From)
         return out;
     } // let
 
-    else if (From.front() == "{")
+    else if (From.front() == tok::lbrace)
     {
         sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
         From.pop_front();
 
-        // Save symbol table for later restoration
-        auto oldTable = table;
+        // Open a scope for later restoration
+        size_t scope = openScope();
 
         out.info = code_scope;
 
-        // Code scope.
+        // Code scope. Each statement is the range of tokens since
+        // the last separator.
         int count = 1;
-        list<string> curVec;
+        size_t statementStart = From.position();
         while (true)
         {
             if (From.empty())
@@ -1376,58 +1382,50 @@ sequence __createSequence(list<string> &From)
                 break;
             }
 
-            if (From.front() == "{")
+            if (From.front() == tok::lbrace)
             {
                 count++;
             }
-            else if (From.front() == "}")
+            else if (From.front() == tok::rbrace)
             {
                 count--;
 
                 if (count == 0)
                 {
-                    out.items.push_back(__createSequence(curVec));
-                    curVec.clear();
+                    tokenCursor statement = From.range(statementStart, From.position());
+                    out.items.push_back(__createSequence(statement));
                     sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
                     From.pop_front();
                     break;
                 }
             }
 
-            if (count == 1 && (From.front() == ";" || From.front() == "}"))
+            if (count == 1 && (From.front() == tok::semicolon || From.front() == tok::rbrace))
             {
-                if (!curVec.empty())
+                if (From.position() != statementStart)
                 {
-                    out.items.push_back(__createSequence(curVec));
+                    tokenCursor statement = From.range(statementStart, From.position());
+                    out.items.push_back(__createSequence(statement));
                     out.items.back().type = nullType;
-                    curVec.clear();
                 }
 
                 sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
                 From.pop_front();
+                statementStart = From.position();
             }
             else
             {
-                if (!From.empty())
-                {
-                    curVec.push_back(From.front());
-                    sm_assert(!From.empty(), "Cannot pop from front of empty vector.");
-                    From.pop_front();
-                }
-                else
-                {
-                    break;
-                }
+                From.pop_front();
             }
         }
 
         // Restore symbol table
 
         // This copies only newly instantiated functions; No other symbols.
-        string output = restoreSymbolTable(oldTable);
+        string output = restoreSymbolTable(scope);
 
         // Call destructors
-        out.items.push_back(sequence{nullType, vector<sequence>(), atom, output});
+        out.items.push_back(sequence{nullType, {}, atom, output});
 
         // Check if/else validity
         for (int i = 1; i < out.items.size(); i++)
@@ -1451,22 +1449,12 @@ sequence __createSequence(list<string> &From)
     // Non-special case; code line.
     // Function calls and template instantiation may occur within.
 
-    while (From.front().size() > 11 && From.front().substr(0, 11) == "//__LINE__=")
-    {
-        // Line update special symbol
-        string newLineNum = From.front().substr(12);
-        curLine = stoull(newLineNum);
-
-        // Pop
-        From.pop_front();
-    }
-
     sequence temp;
     temp.info = atom;
 
     int i = 0;
 
-    vector<string> tempVec;
+    vector<token> tempVec;
     for (auto i : From)
     {
         tempVec.push_back(i);
@@ -1478,7 +1466,7 @@ sequence __createSequence(list<string> &From)
     }
     temp.type = resolveFunction(tempVec, i, temp.raw);
 
-    out.items.push_back(temp);
+    out.items.push_back(move(temp));
 
     // Erase old
     for (int k = 0; !From.empty() && k < i; k++)
@@ -1488,7 +1476,7 @@ sequence __createSequence(list<string> &From)
 
     if (out.items.size() == 1)
     {
-        return out.items[0];
+        return move(out.items[0]);
     }
 
     return out;
@@ -1496,20 +1484,15 @@ sequence __createSequence(list<string> &From)
 
 // This should only be called after method replacement
 // I know I wrote this, but it still feels like black magic and I don't really understand it
-Type resolveFunctionInternal(const vector<string> &What, int &start, vector<string> &c)
+Type resolveFunctionInternal(const vector<token> &What, int &start, vector<string> &c)
 {
-    while (start < What.size() && What[start].size() > 1 && What[start].substr(0, 2) == "//")
-    {
-        start++;
-    }
-
     if (What.empty() || start >= What.size())
     {
         return nullType;
     }
 
     // Pointer check
-    if (What[start] == "@")
+    if (What[start] == tok::at)
     {
         start++;
         c.push_back("&");
@@ -1529,7 +1512,7 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
 
         return type;
     }
-    else if (What[start] == "^")
+    else if (What[start] == tok::caret)
     {
         start++;
 
@@ -1544,19 +1527,12 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
     }
 
     // Semicolon check
-    else if (What[start] == ";")
+    else if (What[start] == tok::semicolon)
     {
         c.push_back(";");
         return nullType;
     }
 
-    // Special symbol check
-    else if (What[start].size() >= 2 && What[start].substr(0, 2) == "//")
-    {
-        start++;
-        return resolveFunctionInternal(What, start, c);
-    }
-
     // Standard case
 
     // get name (first item)
@@ -1564,17 +1540,17 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
     Type type = nullType;
 
     // Parenthesis
-    if (What[start] == "(")
+    if (What[start] == tok::lparen)
     {
-        vector<string> toUse;
+        vector<token> toUse;
         int count = 0;
         do
         {
-            if (What[start] == "(")
+            if (What[start] == tok::lparen)
             {
                 count++;
             }
-            else if (What[start] == ")")
+            else if (What[start] == tok::rparen)
             {
                 count--;
             }
@@ -1606,16 +1582,16 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
 
     // Template instantiation
     bool didTemplate = false;
-    if (What.size() > start + 1 && What[start + 1] == "<")
+    if (What.size() > start + 1 && What[start + 1] == tok::langle)
     {
         start++;
 
-        vector<string> curGen;
-        vector<vector<string>> generics;
+        vector<token> curGen;
+        vector<vector<token>> generics;
         int count = 0;
         do
         {
-            if (What[start] == "<")
+            if (What[start] == tok::langle)
             {
                 count++;
 
@@ -1624,7 +1600,7 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
                     curGen.push_back(What[start]);
                 }
             }
-            else if (What[start] == ">")
+            else if (What[start] == tok::rangle)
             {
                 count--;
 
@@ -1642,7 +1618,7 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
                     curGen.push_back(What[start]);
                 }
             }
-            else if (What[start] == "," && count == 1)
+            else if (What[start] == tok::comma && count == 1)
             {
                 if (curGen.size() > 0)
                 {
@@ -1661,9 +1637,9 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
         // start--;
 
         // should leave w/ what[start] == ';'
-        vector<string> typeVec;
+        vector<token> typeVec;
 
-        while (start < What.size() && What[start] != ";")
+        while (start < What.size() && What[start] != tok::semicolon)
         {
             typeVec.push_back(What[start]);
             start++;
@@ -1682,7 +1658,7 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
     }
 
     // Append literal C code, without interpretation from Oak
-    if (What[start] == "raw_c!")
+    if (What[start] == tok::raw_c_macro)
     {
         // Scrape call to a vector
         int count = 0;
@@ -1690,16 +1666,16 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
         start++;
         do
         {
-            if (What[start] == "(")
+            if (What[start] == tok::lparen)
             {
                 count++;
             }
-            else if (What[start] == ")")
+            else if (What[start] == tok::rparen)
             {
                 count--;
             }
 
-            if (!((What[start] == "(" && count == 1) || (What[start] == ")" && count == 0)))
+            if (!((What[start] == tok::lparen && count == 1) || (What[start] == tok::rparen && count == 0)))
             {
                 // Append raw C code
                 c.push_back(cleanMacroArgument(What[start]));
@@ -1712,27 +1688,27 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
         return Type(atomic, "void");
     }
 
-    else if (What[start] == "size!")
+    else if (What[start] == tok::size_macro)
     {
         // Case for size!() macro
 
         // Scrape entire size!(what) call to a vector
-        vector<string> toAnalyze;
+        vector<token> toAnalyze;
         int count = 0;
 
         start++;
         do
         {
-            if (What[start] == "(")
+            if (What[start] == tok::lparen)
             {
                 count++;
             }
-            else if (What[start] == ")")
+            else if (What[start] == tok::rparen)
             {
                 count--;
             }
 
-            if (!((What[start] == "(" && count == 1) || (What[start] == ")" && count == 0)))
+            if (!((What[start] == tok::lparen && count == 1) || (What[start] == tok::rparen && count == 0)))
             {
                 toAnalyze.push_back(What[start]);
             }
@@ -1760,22 +1736,22 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
         // Otherwise unspecified macro
 
         // Scrape entire call to a vector
-        list<string> toAnalyze = {What[start], "("};
+        vector<token> toAnalyze = {What[start], "("};
         int count = 0;
 
         start++;
         do
         {
-            if (What[start] == "(")
+            if (What[start] == tok::lparen)
             {
                 count++;
             }
-            else if (What[start] == ")")
+            else if (What[start] == tok::rparen)
             {
                 count--;
             }
 
-            if (!((What[start] == "(" && count == 1) || (What[start] == ")" && count == 0)))
+            if (!((What[start] == tok::lparen && count == 1) || (What[start] == tok::rparen && count == 0)))
             {
                 toAnalyze.push_back(What[start]);
             }
@@ -1785,7 +1761,8 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
         toAnalyze.push_back(")");
 
         // Analyze type of collected
-        sequence s = __createSequence(toAnalyze);
+        tokenCursor cursor(toAnalyze);
+        sequence s = __createSequence(cursor);
 
         c.push_back(toC(s));
 
@@ -1793,34 +1770,34 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
     }
 
     // Function call
-    if (What.size() > start + 1 && What[start + 1] == "(")
+    if (What.size() > start + 1 && What[start + 1] == tok::lparen)
     {
         // get args within parenthesis
-        vector<string> curArg;
-        vector<vector<string>> args;
+        vector<token> curArg;
+        vector<vector<token>> args;
 
         int count = 0, templCount = 0;
         start++;
         do
         {
-            if (What[start] == "(")
+            if (What[start] == tok::lparen)
             {
                 count++;
             }
-            else if (What[start] == ")")
+            else if (What[start] == tok::rparen)
             {
                 count--;
             }
-            else if (What[start] == "<")
+            else if (What[start] == tok::langle)
             {
                 templCount++;
             }
-            else if (What[start] == ">")
+            else if (What[start] == tok::rangle)
             {
                 templCount--;
             }
 
-            if (What[start] == "," && count == 1 && templCount == 0)
+            if (What[start] == tok::comma && count == 1 && templCount == 0)
             {
                 args.push_back(curArg);
                 curArg.clear();
@@ -1862,7 +1839,7 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
 
         vector<Type> argTypes;
         vector<string> argStrs;
-        for (vector<string> arg : args)
+        for (vector<token> arg : args)
         {
             int trash = 0;
             string cur;
@@ -1881,57 +1858,23 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
         {
             // Return type is pointer to the thing the array is of
             type = argTypes[0];
-            type[0].info = pointer;
+            type.set(0, {pointer, type[0].name});
             c.push_back("(" + argStrs[0] + "+" + argStrs[1] + ")");
         }
         else
         {
             // Search for candidates
+            instantiatePending(name);
             sm_assert(table.count(name) != 0, "Function call '" + name + "' has no registered symbols.");
             sm_assert(table[name].size() != 0, "Function call '" + name + "' has no registered symbols.");
 
-            vector<__multiTableSymbol> candidates = table[name];
-
-            // Construct candArgs
-            vector<vector<Type>> candArgs;
-            for (auto item : candidates)
-            {
-                Type curType = item.type;
-                while (curType != nullType && curType[0].info == pointer)
-                {
-                    curType.pop_front();
-                }
-
-                auto args = getArgs(item.type);
-                candArgs.push_back(vector<Type>());
-
-                for (auto arg : args)
-                {
-                    if (arg.second == nullType)
-                    {
-                        continue;
-                    }
-
-                    candArgs.back().push_back(arg.second);
-                }
-            }
-
-            vector<int> validCandidates;
+            vector<__multiTableSymbol> &candidates = table[name];
 
             // Do stages of candidacy
-            validCandidates = getExactCandidates(candArgs, argTypes);
-
-            if (validCandidates.size() == 0)
-            {
-                validCandidates = getReferenceCandidates(candArgs, argTypes);
+            bool isAmbiguous;
+            vector<int> validCandidates = getCandidates(name, candidates, argTypes, isAmbiguous);
 
-                if (validCandidates.size() != 1)
-                {
-                    // This also does references
-                    validCandidates = getCastingCandidates(candArgs, argTypes);
-                }
-            }
-            else if (validCandidates.size() > 1)
+            if (isAmbiguous)
             {
                 // Ambiguous candidates
 
@@ -2072,6 +2015,7 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
         if (litType == nullType)
         {
             // Is not a literal
+            instantiatePending(What[start]);
             sm_assert(table.count(What[start]) != 0, "No definitions exist for symbol '" + What[start] + "'.");
             auto candidates = table[What[start]];
             sm_assert(candidates.size() != 0, "No definitions exist for symbol '" + What[start] + "'.");
@@ -2088,7 +2032,7 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
     }
 
     // if member access, resolve that
-    while (start + 1 < What.size() && What[start + 1] == ".")
+    while (start + 1 < What.size() && What[start + 1] == tok::dot)
     {
         // Auto-dereference pointers (. to -> automatically)
         if (type[0].info == pointer)
@@ -2150,7 +2094,7 @@ Type resolveFunctionInternal(const vector<string> &What, int &start, vector<stri
     return type;
 }
 
-Type resolveFunction(const vector<string> &What, int &start, string &c)
+Type resolveFunction(const vector<token> &What, int &start, string &c)
 {
     vector<string> cVec;
 
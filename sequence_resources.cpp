@@ -2,9 +2,8 @@
 #include "symbol_table.hpp"
 #include "type_builder.hpp"
 
-void toCInternal(const sequence &What, vector<string> &out)
+void toCInternal(const sequence &What, string &out)
 {
-    string temp;
 
     switch (What.info)
     {
@@ -15,14 +14,14 @@ void toCInternal(const sequence &What, vector<string> &out)
 
             if (i + 1 != What.items.size())
             {
-                out.push_back(" ");
+                out.append(" ");
             }
         }
 
         break;
 
     case code_scope:
-        out.push_back("{\n");
+        out.append("{\n");
 
         for (int i = 0; i < What.items.size(); i++)
         {
@@ -32,48 +31,53 @@ void toCInternal(const sequence &What, vector<string> &out)
             }
             else if (What.items[i].type == nullType)
             {
-                temp = toC(What.items[i]);
+                // Statements are written in place, then dropped if
+                // they turn out to be empty
+                size_t start = out.size();
+                toCInternal(What.items[i], out);
 
-                if (temp != "" && temp != ";")
+                if (out.size() == start || out.compare(start, string::npos, ";") == 0)
                 {
-                    out.push_back(temp);
-
-                    if (!(temp.size() > 1 && temp.substr(0, 2) == "//"))
+                    out.resize(start);
+                }
+                else
+                {
+                    if (!(out.size() - start > 1 && out.compare(start, 2, "//") == 0))
                     {
-                        out.push_back(";");
+                        out.append(";");
                     }
 
-                    out.push_back("\n");
+                    out.append("\n");
                 }
             }
             else
             {
                 // Janky return
-                out.push_back("return ");
+                out.append("return ");
                 toCInternal(What.items[i], out);
-                out.push_back(";\n");
+                out.append(";\n");
             }
         }
 
-        out.push_back("}");
+        out.append("}");
 
         break;
 
     case atom:
         if (What.raw.size() > 0)
         {
-            out.push_back(What.raw);
+            out.append(What.raw);
         }
         break;
 
     case keyword:
-        out.push_back(What.raw);
-        out.push_back(" ");
+        out.append(What.raw);
+        out.append(" ");
 
         for (auto child : What.items)
         {
             toCInternal(child, out);
-            out.push_back(" ");
+            out.append(" ");
         }
 
         break;
@@ -126,23 +130,22 @@ void toCInternal(const sequence &What, vector<string> &out)
 
                     string captureName = cur.items[1].raw;
 
-                    auto backupTable = table;
-
                     if (ind != 0)
                     {
-                        out.push_back("else ");
+                        out.append("else ");
                     }
 
-                    out.push_back("if (");
+                    out.append("if (");
 
+                    size_t itemStart = out.size();
                     toCInternal(What.items[0], out);
-                    string itemStr = out.back();
+                    string itemStr = out.substr(itemStart);
 
-                    out.push_back(".__info == ");
-                    out.push_back(typeStr);
-                    out.push_back("_OPT_");
-                    out.push_back(optionName);
-                    out.push_back(")\n{");
+                    out.append(".__info == ");
+                    out.append(typeStr);
+                    out.append("_OPT_");
+                    out.append(optionName);
+                    out.append(")\n{");
 
                     if (captureName != "NULL")
                     {
@@ -159,7 +162,7 @@ void toCInternal(const sequence &What, vector<string> &out)
 
                         if (atomics.count(captureType) == 0)
                         {
-                            out.push_back("struct ");
+                            out.append("struct ");
                         }
 
                         for (int l = 0; l < numPtrs; l++)
@@ -167,20 +170,20 @@ void toCInternal(const sequence &What, vector<string> &out)
                             captureType += "*";
                         }
 
-                        out.push_back(captureType);
-                        out.push_back(" *");
-                        out.push_back(captureName);
-                        out.push_back(" = &");
-                        out.push_back(itemStr);
-                        out.push_back(".__data.");
-                        out.push_back(optionName);
-                        out.push_back("_data;\n");
+                        out.append(captureType);
+                        out.append(" *");
+                        out.append(captureName);
+                        out.append(" = &");
+                        out.append(itemStr);
+                        out.append(".__data.");
+                        out.append(optionName);
+                        out.append("_data;\n");
                     }
 
                     // Add capture group to Oak table if needed
 
                     toCInternal(cur.items[2], out);
-                    out.push_back("\n}\n");
+                    out.append("\n}\n");
                 }
                 else if (What.items[1].items[ind].raw == "default")
                 {
@@ -195,15 +198,15 @@ void toCInternal(const sequence &What, vector<string> &out)
 
                     if (ind == 0)
                     {
-                        out.push_back("{\n");
+                        out.append("{\n");
                         toCInternal(cur.items[0], out);
-                        out.push_back("\n}\n");
+                        out.append("\n}\n");
                     }
                     else
                     {
-                        out.push_back("else\n{\n");
+                        out.append("else\n{\n");
                         toCInternal(cur.items[0], out);
-                        out.push_back("\n}\n");
+                        out.append("\n}\n");
                     }
                 }
                 else if (What.items[1].items[ind].raw != "")
@@ -231,12 +234,12 @@ void toCInternal(const sequence &What, vector<string> &out)
                  << "'. Treating as regular keyword.\n"
                  << tags::reset;
 
-            out.push_back(What.raw);
-            out.push_back(" ");
+            out.append(What.raw);
+            out.append(" ");
             for (auto child : What.items)
             {
                 toCInternal(child, out);
-                out.push_back(" ");
+                out.append(" ");
             }
         }
 
@@ -249,23 +252,9 @@ void toCInternal(const sequence &What, vector<string> &out)
 // Turn a .oak sequence into a .cpp one
 string toC(const sequence &What)
 {
-    vector<string> out;
+    string out;
     toCInternal(What, out);
-
-    int size = 0;
-    for (const auto &what : out)
-    {
-        size += what.size();
-    }
-
-    string outStr;
-    outStr.reserve(size);
-    for (const auto &what : out)
-    {
-        outStr += what;
-    }
-
-    return outStr;
+    return out;
 }
 
 // Get the return type from a Type (of a function signature)
@@ -431,26 +420,15 @@ vector<pair<string, Type>> getArgs(Type &type)
 }
 
 // Can throw errors (IE malformed definitions)
-void addEnum(const vector<string> &FromIn)
+void addEnum(const vector<token> &From)
 {
-    vector<string> From;
-
-    // Clean input of any special symbols
-    for (auto f : FromIn)
-    {
-        if (f.size() < 2 || f.substr(0, 2) != "//")
-        {
-            From.push_back(f);
-        }
-    }
-
     // Assert the expression can be properly-formed
     parse_assert(From.size() >= 4);
 
     // Get name and check against malformations
     int i = 0;
 
-    parse_assert(From[i] == "let");
+    parse_assert(From[i] == tok::let_kw);
     i++;
 
     string name = From[i];
@@ -459,13 +437,13 @@ void addEnum(const vector<string> &FromIn)
     parse_assert(i < From.size());
 
     // Scrape generics here (and mangle)
-    vector<string> curGen;
-    vector<vector<string>> generics;
+    vector<token> curGen;
+    vector<vector<token>> generics;
 
     int count = 0;
-    while (i < From.size() && From[i] != ":" && From[i] != "{")
+    while (i < From.size() && From[i] != tok::colon && From[i] != tok::lbrace)
     {
-        if (From[i] == "<")
+        if (From[i] == tok::langle)
         {
             count++;
 
@@ -476,7 +454,7 @@ void addEnum(const vector<string> &FromIn)
             }
         }
 
-        else if (From[i] == ">")
+        else if (From[i] == tok::rangle)
         {
             count--;
 
@@ -486,7 +464,7 @@ void addEnum(const vector<string> &FromIn)
             }
         }
 
-        else if (From[i] == "<")
+        else if (From[i] == tok::langle)
         {
             count++;
         }
@@ -529,24 +507,24 @@ void addEnum(const vector<string> &FromIn)
     table["New"];
     table["Del"];
 
-    table["New"].push_back(__multiTableSymbol{s, t, false, curFile});
-    table["Del"].push_back(__multiTableSymbol{s, t, false, curFile});
+    table["New"].push_back(__multiTableSymbol{newBody(s), t, false, curFile});
+    table["Del"].push_back(__multiTableSymbol{newBody(s), t, false, curFile});
 
-    parse_assert(From[i] == ":");
+    parse_assert(From[i] == tok::colon);
     i++;
-    parse_assert(From[i] == "enum");
+    parse_assert(From[i] == tok::enum_kw);
     i++;
 
-    if (From[i] == "{")
+    if (From[i] == tok::lbrace)
     {
         i++;
-        for (; i < From.size() && From[i] != "}"; i++)
+        for (; i < From.size() && From[i] != tok::rbrace; i++)
         {
             // name : type ,
             // name , name2 , name3 : type < string , hi > , name4 : type2 ,
-            vector<string> names, lexedType;
+            vector<token> names, lexedType;
 
-            while (i + 1 < From.size() && From[i + 1] == ",")
+            while (i + 1 < From.size() && From[i + 1] == tok::comma)
             {
                 names.push_back(From[i]);
 
@@ -556,17 +534,17 @@ void addEnum(const vector<string> &FromIn)
             names.push_back(From[i]);
 
             parse_assert(i + 1 < From.size());
-            parse_assert(From[i + 1] == ":");
+            parse_assert(From[i + 1] == tok::colon);
 
             i += 2;
 
             // Get lexed type (can be multiple symbols due to templating)
             int templCount = 0;
-            vector<string> genericHolder;
+            vector<token> genericHolder;
 
-            while (i < From.size() && !(templCount == 0 && From[i] == ","))
+            while (i < From.size() && !(templCount == 0 && From[i] == tok::comma))
             {
-                if (templCount == 0 && From[i] != "<")
+                if (templCount == 0 && From[i] != tok::langle)
                 {
                     lexedType.push_back(From[i]);
                 }
@@ -575,11 +553,11 @@ void addEnum(const vector<string> &FromIn)
                     genericHolder.push_back(From[i]);
                 }
 
-                if (From[i] == "<")
+                if (From[i] == tok::langle)
                 {
                     templCount++;
                 }
-                else if (From[i] == ">")
+                else if (From[i] == tok::rangle)
                 {
                     templCount--;
 
@@ -590,7 +568,7 @@ void addEnum(const vector<string> &FromIn)
 
                         if (toAdd != "")
                         {
-                            lexedType.back().append("_" + toAdd);
+                            lexedType.back() = lexedType.back() + ("_" + toAdd);
                         }
                     }
                 }
@@ -606,7 +584,7 @@ void addEnum(const vector<string> &FromIn)
             }
         }
     }
-    else if (From[4] != ";")
+    else if (From[4] != tok::semicolon)
     {
         throw parse_error("Malformed enum definition; Expected ';' or '{'.");
     }
@@ -621,7 +599,6 @@ void addEnum(const vector<string> &FromIn)
 
             // Insert Oak version
             Type constructorType = nullType;
-            constructorType.reserve(6);
 
             constructorType.append(function);
             constructorType.append(var_name, "self");
@@ -630,7 +607,7 @@ void addEnum(const vector<string> &FromIn)
             constructorType.append(maps);
             constructorType.append(atomic, "void");
 
-            table["wrap_" + optionName].push_back(__multiTableSymbol{sequence{}, constructorType, false, curFile});
+            table["wrap_" + optionName].push_back(__multiTableSymbol{newBody(), constructorType, false, curFile});
         }
         else
         {
@@ -638,7 +615,6 @@ void addEnum(const vector<string> &FromIn)
 
             // Insert Oak version
             Type constructorType = nullType;
-            constructorType.reserve(9);
 
             constructorType.append(function);
             constructorType.append(var_name, "self");
@@ -650,7 +626,7 @@ void addEnum(const vector<string> &FromIn)
             constructorType.append(maps);
             constructorType.append(atomic, "void");
 
-            table["wrap_" + optionName].push_back(__multiTableSymbol{sequence{}, constructorType, false, curFile});
+            table["wrap_" + optionName].push_back(__multiTableSymbol{newBody(), constructorType, false, curFile});
         }
     }
 
@@ -658,8 +634,8 @@ void addEnum(const vector<string> &FromIn)
 }
 
 // Dump data to file
-void dump(const vector<string> &Lexed, const string &Where, const string &FileName, const int &Line,
-          const sequence &FileSeq, const vector<string> LexedBackup)
+void dump(const tokenBuffer &Lexed, const string &Where, const string &FileName, const int &Line,
+          const sequence &FileSeq, const vector<token> LexedBackup)
 {
     string sep = "";
     for (int i = 0; i < 50; i++)
@@ -680,31 +656,31 @@ void dump(const vector<string> &Lexed, const string &Where, const string &FileNa
 
     file << sep << "// Pre-everything lexed:\n";
 
+    unsigned int line = 0;
     for (auto s : LexedBackup)
     {
-        if (s.size() >= 2 && s.substr(0, 2) == "//")
+        if (s.line != line)
         {
-            file << "\n" << s << "\t|\t";
-        }
-        else
-        {
-            file << s << ' ';
+            line = s.line;
+            file << "\n//__LINE__=" << line << "\t|\t";
         }
+
+        file << s << ' ';
     }
     file << '\n';
 
     file << sep << "// Post-substitution lexed:\n";
 
+    line = 0;
     for (auto s : Lexed)
     {
-        if (s.size() >= 2 && s.substr(0, 2) == "//")
+        if (s.line != line)
         {
-            file << "\n" << s << "\t|\t";
-        }
-        else
-        {
-            file << s << ' ';
+            line = s.line;
+            file << "\n//__LINE__=" << line << "\t|\t";
         }
+
+        file << s << ' ';
     }
     file << '\n';
 
@@ -1021,6 +997,99 @@ vector<int> getReferenceCandidates(const vector<vector<Type>> &candArgs, const v
     return out;
 }
 
+unordered_map<string, __overloadIndex> overloadIndices;
+
+vector<int> getCandidates(const string &Name, vector<__multiTableSymbol> &Candidates, const vector<Type> &ArgTypes,
+                          bool &Ambiguous)
+{
+    __overloadIndex &index = overloadIndices[Name];
+
+    // Rebuild if any symbol has changed
+    bool isCurrent = index.typeIDs.size() == Candidates.size();
+    for (size_t i = 0; isCurrent && i < Candidates.size(); i++)
+    {
+        isCurrent = index.typeIDs[i] == Candidates[i].type.ID;
+    }
+
+    if (!isCurrent)
+    {
+        index = __overloadIndex();
+
+        for (size_t i = 0; i < Candidates.size(); i++)
+        {
+            index.typeIDs.push_back(Candidates[i].type.ID);
+
+            vector<Type> args;
+            for (auto &arg : getArgs(Candidates[i].type))
+            {
+                if (arg.second == nullType)
+                {
+                    continue;
+                }
+
+                args.push_back(arg.second);
+            }
+
+            index.positions[args.size()].push_back(i);
+            index.candArgs[args.size()].push_back(args);
+        }
+    }
+
+    string key;
+    for (const auto &type : ArgTypes)
+    {
+        for (const auto &node : type.nodes())
+        {
+            key.push_back((char)node.info);
+            key.append(node.name);
+            key.push_back('\0');
+        }
+        key.push_back('\n');
+    }
+
+    auto found = index.resolved.find(key);
+    if (found != index.resolved.end())
+    {
+        Ambiguous = found->second.second;
+        return found->second.first;
+    }
+
+    // Candidates with a different number of arguments never match
+    vector<int> out;
+    Ambiguous = false;
+
+    if (index.candArgs.count(ArgTypes.size()) != 0)
+    {
+        const vector<vector<Type>> &candArgs = index.candArgs[ArgTypes.size()];
+
+        out = getExactCandidates(candArgs, ArgTypes);
+
+        if (out.size() == 0)
+        {
+            out = getReferenceCandidates(candArgs, ArgTypes);
+
+            if (out.size() != 1)
+            {
+                // This also does references
+                out = getCastingCandidates(candArgs, ArgTypes);
+            }
+        }
+        else if (out.size() > 1)
+        {
+            Ambiguous = true;
+        }
+
+        for (auto &i : out)
+        {
+            i = index.positions[ArgTypes.size()][i];
+        }
+    }
+
+    index.resolved[key] = make_pair(out, Ambiguous);
+
+    return out;
+}
+
 ////////////////////////////////////////////////////////////////
 
 // Prints the reason why each candidate was rejected
@@ -1184,9 +1253,9 @@ void destroyUnits(const string &name, const Type &type, const bool &doThrow)
             if (table[name][i].type == type)
             {
                 // If is unit, erase
-                if (table[name][i].seq.items.size() == 0 ||
-                    (table[name][i].seq.items.size() >= 1 && table[name][i].seq.items[0].raw.size() > 8 &&
-                     table[name][i].seq.items[0].raw.substr(0, 9) == "//AUTOGEN"))
+                if (table[name][i].seq->items.size() == 0 ||
+                    (table[name][i].seq->items.size() >= 1 && table[name][i].seq->items[0].raw.size() > 8 &&
+                     table[name][i].seq->items[0].raw.substr(0, 9) == "//AUTOGEN"))
                 {
                     table.at(name).erase(table[name].begin() + i);
                     i--;
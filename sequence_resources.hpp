@@ -18,6 +18,7 @@ jdehmel@outlook.com
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "enums.hpp"
@@ -26,6 +27,7 @@ jdehmel@outlook.com
 #include "mem.hpp"
 #include "reconstruct.hpp"
 #include "symbol_table.hpp"
+#include "token_buffer.hpp"
 #include "type_builder.hpp"
 
 #include "tags.hpp"
@@ -37,7 +39,7 @@ extern unsigned long long int curLine;
 extern string curFile;
 
 // For error trace
-extern vector<string> curLineSymbols;
+extern vector<token> curLineSymbols;
 
 // Extension of runtime error for Oak sequencing
 class sequencing_error : public runtime_error
@@ -71,13 +73,13 @@ vector<pair<string, Type>> getArgs(Type &type);
 void debugPrint(const sequence &What, int spaces = 0, ostream &to = cout);
 
 Type checkLiteral(const string &From);
-string restoreSymbolTable(multiSymbolTable &backup);
+string restoreSymbolTable(const size_t &Scope);
 
-void addEnum(const vector<string> &FromIn);
+void addEnum(const vector<token> &From);
 
 // Dump data to file
-void dump(const vector<string> &Lexed, const string &Where, const string &FileName, const int &Line,
-          const sequence &FileSeq, const vector<string> LexedBackup);
+void dump(const tokenBuffer &Lexed, const string &Where, const string &FileName, const int &Line,
+          const sequence &FileSeq, const vector<token> LexedBackup);
 
 string getMemberNew(const string &selfName, const string &varName, const Type &varType);
 string getMemberDel(const string &selfName, const string &varName, const Type &varType);
@@ -103,6 +105,35 @@ vector<int> getCastingCandidates(const vector<vector<Type>> &candArgs, const vec
 // dereferencing. Works as above.
 vector<int> getReferenceCandidates(const vector<vector<Type>> &candArgs, const vector<Type> &argTypes);
 
+/*
+The overloads of one name, indexed for getCandidates. Every
+change to a Type gives it a new ID, so the IDs of the symbols'
+types tell when the index is out of date.
+*/
+struct __overloadIndex
+{
+    vector<unsigned long long> typeIDs;
+
+    // The argument types of the candidates of each arity, and
+    // their positions among all the candidates
+    map<size_t, vector<vector<Type>>> candArgs;
+    map<size_t, vector<int>> positions;
+
+    // Previous results, by argument types
+    unordered_map<string, pair<vector<int>, bool>> resolved;
+};
+
+// Overload indices by function name, for the current table
+extern unordered_map<string, __overloadIndex> overloadIndices;
+
+// Runs the above stages as a function call does: Exact, then
+// referencing, then casting. Returns the indices into Candidates
+// (the symbols of Name) which remain, and sets Ambiguous if more
+// than one matched exactly. Results are kept until Name's symbols
+// change.
+vector<int> getCandidates(const string &Name, vector<__multiTableSymbol> &Candidates, const vector<Type> &ArgTypes,
+                          bool &Ambiguous);
+
 // Prints the reason why each candidate was rejected
 void printCandidateErrors(const vector<__multiTableSymbol> &candidates, const vector<Type> &argTypes,
                           const string &name);
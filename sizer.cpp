@@ -1,32 +1,41 @@
 #include "sizer.hpp"
+#include <filesystem>
+#include <sys/stat.h>
 
 unsigned long long int getSize(const string &FilePath)
 {
-#if (defined(_WIN32) || defined(_WIN64) || defined(__APPLE__))
-    cout << "Cannot call the getSize function outside of Linux.\n";
+#if (defined(_WIN32) || defined(_WIN64))
+    cout << "Cannot call the getSize function on Windows.\n";
     return 0;
-#endif
-
-    // Run command
-    if (system(("du -s " + FilePath + " > sizer_temp.txt 2> /dev/null").c_str()) != 0)
+#else
+    // Count allocated blocks rather than file sizes, like du
+    struct stat info;
+    if (lstat(FilePath.c_str(), &info) != 0)
     {
-        throw_assert(system("rm -f sizer_temp.txt") == 0);
-
         // If file does not exist, 0 bytes
         return 0;
     }
 
-    // Load file
-    ifstream inp("sizer_temp.txt");
-    throw_assert(inp.is_open());
-
-    unsigned long long int kb;
-    inp >> kb;
+    unsigned long long int blocks = info.st_blocks;
 
-    inp.close();
-    throw_assert(system("rm -f sizer_temp.txt") == 0);
+    if (S_ISDIR(info.st_mode))
+    {
+        error_code error;
+        for (filesystem::recursive_directory_iterator
+                 it(FilePath, filesystem::directory_options::skip_permission_denied, error),
+             end;
+             !error && it != end; it.increment(error))
+        {
+            if (lstat(it->path().c_str(), &info) == 0)
+            {
+                blocks += info.st_blocks;
+            }
+        }
+    }
 
-    return kb;
+    // st_blocks is in 512 byte units
+    return blocks / 2;
+#endif
 }
 
 string humanReadable(const unsigned long long int &Size)
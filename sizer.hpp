@@ -18,7 +18,7 @@ compiler frontend.
 #include <string>
 using namespace std;
 
-// Use system calls to get the size in kilobytes of a given filepath
+// Get the size in kilobytes of a given filepath, as du -s would
 unsigned long long int getSize(const string &FilePath);
 
 // Turn the output of getSize into a human-readable string
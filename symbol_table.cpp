@@ -12,32 +12,114 @@ GPLv3 held by author
 
 multiSymbolTable table;
 
-// Converts lexed symbols into a type
-Type toType(const vector<string> &WhatIn)
+// The sequence arena's current chunk
+#define SEQUENCE_CHUNK_SIZE (1 << 20)
+static char *sequenceArenaPos = nullptr, *sequenceArenaEnd = nullptr;
+
+// Size classes are powers of two, from 16 bytes up to an eighth
+// of a chunk. Each freed block holds the next one on its list.
+#define SEQUENCE_MIN_CLASS 4
+#define SEQUENCE_MAX_CLASS 17
+static void *sequenceFreeLists[SEQUENCE_MAX_CLASS + 1] = {};
+
+static unsigned int getSequenceClass(const size_t &Bytes)
 {
-    if (WhatIn.size() == 0)
+    unsigned int out = SEQUENCE_MIN_CLASS;
+    while (((size_t)1 << out) < Bytes)
     {
-        return Type(atomic, "NULL");
+        out++;
     }
+    return out;
+}
 
-    vector<string> What;
-    for (string s : WhatIn)
+static void pushSequenceBlock(void *What, const unsigned int &Class)
+{
+    *(void **)What = sequenceFreeLists[Class];
+    sequenceFreeLists[Class] = What;
+    return;
+}
+
+void *allocateSequences(const size_t &Bytes)
+{
+    unsigned int sizeClass = getSequenceClass(Bytes);
+
+    // Large blocks get their own allocation, so as not to waste
+    // the rest of the chunk
+    if (sizeClass > SEQUENCE_MAX_CLASS)
+    {
+        return ::operator new(Bytes);
+    }
+
+    void *out = sequenceFreeLists[sizeClass];
+    if (out != nullptr)
+    {
+        sequenceFreeLists[sizeClass] = *(void **)out;
+        return out;
+    }
+
+    size_t size = (size_t)1 << sizeClass;
+    if (size > (size_t)(sequenceArenaEnd - sequenceArenaPos))
     {
-        if (s.size() < 2 || s.substr(0, 2) != "//")
+        // The rest of the old chunk is still of use
+        for (unsigned int c = SEQUENCE_MAX_CLASS; c >= SEQUENCE_MIN_CLASS; c--)
         {
-            What.push_back(s);
+            while (((size_t)1 << c) <= (size_t)(sequenceArenaEnd - sequenceArenaPos))
+            {
+                pushSequenceBlock(sequenceArenaPos, c);
+                sequenceArenaPos += (size_t)1 << c;
+            }
         }
+
+        sequenceArenaPos = (char *)::operator new(SEQUENCE_CHUNK_SIZE);
+        sequenceArenaEnd = sequenceArenaPos + SEQUENCE_CHUNK_SIZE;
     }
 
+    out = sequenceArenaPos;
+    sequenceArenaPos += size;
+    return out;
+}
+
+void freeSequences(void *What, const size_t &Bytes)
+{
+    if (What == nullptr)
+    {
+        return;
+    }
+
+    unsigned int sizeClass = getSequenceClass(Bytes);
+    if (sizeClass > SEQUENCE_MAX_CLASS)
+    {
+        ::operator delete(What);
+    }
+    else
+    {
+        pushSequenceBlock(What, sizeClass);
+    }
+
+    return;
+}
+
+// A deque, so that pointers into it are never invalidated
+static deque<sequence> bodies;
+
+sequence *newBody(const sequence &From)
+{
+    bodies.push_back(From);
+    return &bodies.back();
+}
+
+// Converts lexed symbols into a type
+Type toType(const vector<token> &What)
+{
     if (What.size() == 0)
     {
         return Type(atomic, "NULL");
     }
 
     int i = 0;
-    if (What[i] == "<")
+    if (What[i] == tok::langle)
     {
-        while (i < What.size() && What[i] != ">")
+        while (i < What.size() && What[i] != tok::rangle)
         {
             i++;
         }
@@ -47,25 +129,25 @@ Type toType(const vector<string> &WhatIn)
     Type out;
     for (; i < What.size(); i++)
     {
-        string cur = What[i];
+        const token &cur = What[i];
 
-        if (cur == "^" || cur == "@")
+        if (cur == tok::caret || cur == tok::at)
         {
             out.append(pointer);
         }
-        else if (cur == "<")
+        else if (cur == tok::langle)
         {
             throw_assert(out != nullType);
 
             // Append to back
 
             // Collect generics
-            vector<string> curGen;
-            vector<vector<string>> generics;
+            vector<token> curGen;
+            vector<vector<token>> generics;
             int count = 0;
             do
             {
-                if (What[i] == "<")
+                if (What[i] == tok::langle)
                 {
                     count++;
 
@@ -74,7 +156,7 @@ Type toType(const vector<string> &WhatIn)
                         curGen.push_back(What[i]);
                     }
                 }
-                else if (What[i] == ">")
+                else if (What[i] == tok::rangle)
                 {
                     count--;
 
@@ -92,7 +174,7 @@ Type toType(const vector<string> &WhatIn)
                         curGen.push_back(What[i]);
                     }
                 }
-                else if (What[i] == "," && count == 1)
+                else if (What[i] == tok::comma && count == 1)
                 {
                     if (curGen.size() > 0)
                     {
@@ -111,16 +193,16 @@ Type toType(const vector<string> &WhatIn)
             i--;
 
             // At this point, will only ever be a struct
-            vector<string> temp;
+            vector<token> temp;
             temp.push_back("struct");
 
-            out[out.size() - 1].name = instantiateGeneric(out[out.size() - 1].name, generics, temp);
+            out.set(out.size() - 1, {out[out.size() - 1].info, instantiateGeneric(out[out.size() - 1].name, generics, temp)});
         }
-        else if (cur == ",")
+        else if (cur == tok::comma)
         {
             out.append(join);
         }
-        else if (cur == "->")
+        else if (cur == tok::arrow)
         {
             out.append(maps);
         }
@@ -152,19 +234,19 @@ Type toType(const vector<string> &WhatIn)
         {
             ;
         }
-        else if (cur == ")" || cur == ":" || cur == ";")
+        else if (cur == tok::rparen || cur == tok::colon || cur == tok::semicolon)
         {
             ;
         }
-        else if (cur == "(")
+        else if (cur == tok::lparen)
         {
             out.append(function);
         }
-        else if (cur == "let")
+        else if (cur == tok::let_kw)
         {
             i++;
         }
-        else if (What.size() > i + 1 && What[i + 1] == ":")
+        else if (What.size() > i + 1 && What[i + 1] == tok::colon)
         {
             out.append(var_name, cur);
         }
@@ -189,39 +271,28 @@ Type toType(const vector<string> &WhatIn)
 }
 
 // Can throw errors (IE malformed definitions)
-void addStruct(const vector<string> &FromIn)
+void addStruct(const vector<token> &From)
 {
-    vector<string> From;
-
-    // Clean input of any special symbols
-    for (auto f : FromIn)
-    {
-        if (f.size() < 2 || f.substr(0, 2) != "//")
-        {
-            From.push_back(f);
-        }
-    }
-
     // Assert the expression can be properly-formed
     parse_assert(From.size() >= 4);
 
     // Get name and check against malformations
     int i = 0;
 
-    parse_assert(From[i] == "let");
+    parse_assert(From[i] == tok::let_kw);
     i++;
 
     string name = From[i];
 
     // Scrape generics here (and mangle)
-    vector<vector<string>> generics;
-    vector<string> curGen;
+    vector<vector<token>> generics;
+    vector<token> curGen;
 
     i++;
     int count = 0;
-    while (i < From.size() && From[i] != ":" && From[i] != "{")
+    while (i < From.size() && From[i] != tok::colon && From[i] != tok::lbrace)
     {
-        if (From[i] == "<")
+        if (From[i] == tok::langle)
         {
             count++;
 
@@ -232,7 +303,7 @@ void addStruct(const vector<string> &FromIn)
             }
         }
 
-        else if (From[i] == ">")
+        else if (From[i] == tok::rangle)
         {
             count--;
 
@@ -242,7 +313,7 @@ void addStruct(const vector<string> &FromIn)
             }
         }
 
-        else if (From[i] == "<")
+        else if (From[i] == tok::langle)
         {
             count++;
         }
@@ -285,24 +356,24 @@ void addStruct(const vector<string> &FromIn)
     table["New"];
     table["Del"];
 
-    table["New"].push_back(__multiTableSymbol{s, t});
-    table["Del"].push_back(__multiTableSymbol{s, t});
+    table["New"].push_back(__multiTableSymbol{newBody(s), t});
+    table["Del"].push_back(__multiTableSymbol{newBody(s), t});
 
-    parse_assert(i < From.size() && From[i] == ":");
+    parse_assert(i < From.size() && From[i] == tok::colon);
     i++;
-    parse_assert(From[i] == "struct");
+    parse_assert(From[i] == tok::struct_kw);
     i++;
 
-    if (From[i] == "{")
+    if (From[i] == tok::lbrace)
     {
         i++;
-        for (; i < From.size() && From[i] != "}"; i++)
+        for (; i < From.size() && From[i] != tok::rbrace; i++)
         {
             // name : type ,
             // name , name2 , name3 : type < string , hi > , name4 : type2 ,
-            vector<string> names, lexedType;
+            vector<token> names, lexedType;
 
-            while (i + 1 < From.size() && From[i + 1] == ",")
+            while (i + 1 < From.size() && From[i + 1] == tok::comma)
             {
                 names.push_back(From[i]);
 
@@ -312,17 +383,17 @@ void addStruct(const vector<string> &FromIn)
             names.push_back(From[i]);
 
             parse_assert(i + 1 < From.size());
-            parse_assert(From[i + 1] == ":");
+            parse_assert(From[i + 1] == tok::colon);
 
             i += 2;
 
             // Get lexed type (can be multiple symbols due to templating)
             int templCount = 0;
-            vector<string> genericHolder;
+            vector<token> genericHolder;
 
-            while (i < From.size() && !(templCount == 0 && From[i] == ","))
+            while (i < From.size() && !(templCount == 0 && From[i] == tok::comma))
             {
-                if (templCount == 0 && From[i] != "<")
+                if (templCount == 0 && From[i] != tok::langle)
                 {
                     lexedType.push_back(From[i]);
                 }
@@ -331,11 +402,11 @@ void addStruct(const vector<string> &FromIn)
                     genericHolder.push_back(From[i]);
                 }
 
-                if (From[i] == "<")
+                if (From[i] == tok::langle)
                 {
                     templCount++;
                 }
-                else if (From[i] == ">")
+                else if (From[i] == tok::rangle)
                 {
                     templCount--;
 
@@ -346,7 +417,7 @@ void addStruct(const vector<string> &FromIn)
 
                         if (toAdd != "")
                         {
-                            lexedType.back().append("_" + toAdd);
+                            lexedType.back() = lexedType.back() + ("_" + toAdd);
                         }
                     }
                 }
@@ -361,18 +432,18 @@ void addStruct(const vector<string> &FromIn)
                 structData[name].order.push_back(varName);
 
                 // Add semicolon
-                table["New"].back().seq.items.push_back(sequence{nullType, vector<sequence>(), atom, ";"});
+                table["New"].back().seq->items.push_back(sequence{nullType, {}, atom, ";"});
 
                 sequence toAppend;
                 toAppend.info = atom;
                 toAppend.type = nullType;
                 toAppend.raw = getMemberNew("(*what)", varName, toAdd);
 
-                table["New"].back().seq.items.push_back(toAppend);
+                table["New"].back().seq->items.push_back(move(toAppend));
             }
         }
     }
-    else if (From[4] != ";")
+    else if (From[4] != tok::semicolon)
     {
         throw parse_error("Malformed struct definition; Expected ';' or '{'.");
     }
@@ -380,28 +451,76 @@ void addStruct(const vector<string> &FromIn)
     return;
 }
 
+/*
+The types each name held before it was first given a variable
+in a scope, one map per open scope, innermost last. If a scope
+has saved a name, so has every scope outside of it.
+*/
+static vector<map<string, vector<Type>>> scopes;
+
+size_t openScope()
+{
+    scopes.emplace_back();
+    return scopes.size() - 1;
+}
+
+void saveSymbols(const string &Name)
+{
+    for (int i = (int)scopes.size() - 1; i >= 0 && scopes[i].count(Name) == 0; i--)
+    {
+        vector<Type> &backup = scopes[i][Name];
+
+        auto found = table.find(Name);
+        if (found != table.end())
+        {
+            for (const auto &s : found->second)
+            {
+                backup.push_back(s.type);
+            }
+        }
+    }
+
+    return;
+}
+
 /*
 Erases any non-function symbols which were not present
-in the original table. However, skips all functions.
-If not contradicted by the above rules, bases off of
-the current table (not backup).
+when the scope opened. However, skips all functions.
+Names which were not given a variable in the scope are
+left as they are.
 */
-string restoreSymbolTable(multiSymbolTable &backup)
+string restoreSymbolTable(const size_t &Scope)
 {
     string output = "";
 
-    multiSymbolTable newTable;
-    for (auto p : table)
+    if (Scope >= scopes.size())
+    {
+        throw runtime_error("Internal error; Cannot close a scope which is not open.");
+    }
+
+    // Scopes left open by errors close along with this one
+    scopes.resize(Scope + 1);
+
+    map<string, vector<Type>> changed;
+    swap(changed, scopes.back());
+    scopes.pop_back();
+
+    for (auto &p : changed)
     {
-        for (auto s : p.second)
+        auto found = table.find(p.first);
+        if (found == table.end())
+        {
+            continue;
+        }
+
+        vector<__multiTableSymbol> kept;
+        for (auto &s : found->second)
         {
             // Functions are always added- the logic for
             // this is handled elsewhere.
             if (s.type[0].info == function)
             {
-                // Add to new table for sure
-                newTable[p.first];
-                newTable[p.first].push_back(s);
+                kept.push_back(s);
             }
 
             // Variables are more complicated
@@ -409,9 +528,9 @@ string restoreSymbolTable(multiSymbolTable &backup)
             {
                 // Check for presence in backup
                 bool present = false;
-                for (auto cand : backup[p.first])
+                for (const auto &cand : p.second)
                 {
-                    if (cand.type == s.type)
+                    if (cand == s.type)
                     {
                         present = true;
                         break;
@@ -421,9 +540,7 @@ string restoreSymbolTable(multiSymbolTable &backup)
                 // If was present in backup, add for sure
                 if (present)
                 {
-                    // Add to table for sure
-                    newTable[p.first];
-                    newTable[p.first].push_back(s);
+                    kept.push_back(s);
                 }
 
                 // Otherwise, do not add (do destructor literal check)
@@ -446,9 +563,16 @@ string restoreSymbolTable(multiSymbolTable &backup)
                 }
             }
         }
-    }
 
-    table = newTable;
+        if (kept.empty())
+        {
+            table.erase(found);
+        }
+        else
+        {
+            found->second = move(kept);
+        }
+    }
 
     return output;
 }
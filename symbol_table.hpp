@@ -11,6 +11,7 @@ Handles the Oak symbol table.
 #ifndef SYMBOL_TABLE_HPP
 #define SYMBOL_TABLE_HPP
 
+#include <deque>
 #include <iostream>
 #include <map>
 #include <stdexcept>
@@ -33,7 +34,7 @@ class parse_error : public runtime_error
 #define parse_assert(what) ((bool)(what)) ? true : (throw parse_error("Assertion '" #what "' failed."))
 
 // External definition
-string mangle(const vector<string> &what);
+string mangle(const vector<token> &what);
 
 enum sequenceInfo
 {
@@ -44,10 +45,48 @@ enum sequenceInfo
     enum_keyword,
 };
 
+// Sequence trees are bump allocated from one arena, in power of
+// two size classes. Freed blocks go on their class's free list to
+// be reused; Blocks too big for any class are freed outright.
+void *allocateSequences(const size_t &Bytes);
+void freeSequences(void *What, const size_t &Bytes);
+
+template <class T> struct sequenceAllocator
+{
+    typedef T value_type;
+
+    sequenceAllocator() = default;
+
+    template <class U> sequenceAllocator(const sequenceAllocator<U> &)
+    {
+    }
+
+    T *allocate(const size_t &N)
+    {
+        return (T *)allocateSequences(N * sizeof(T));
+    }
+
+    void deallocate(T *What, const size_t &N)
+    {
+        freeSequences(What, N * sizeof(T));
+        return;
+    }
+};
+
+template <class T, class U> bool operator==(const sequenceAllocator<T> &, const sequenceAllocator<U> &)
+{
+    return true;
+}
+
+template <class T, class U> bool operator!=(const sequenceAllocator<T> &, const sequenceAllocator<U> &)
+{
+    return false;
+}
+
 struct sequence
 {
     Type type;
-    vector<sequence> items;
+    vector<sequence, sequenceAllocator<sequence>> items;
     sequenceInfo info = code_line;
     string raw; // If needed
 };
@@ -55,7 +94,8 @@ struct sequence
 // For internal use
 struct __multiTableSymbol
 {
-    sequence seq;
+    // Owned by the body arena; See newBody
+    sequence *seq = nullptr;
     Type type;
 
     bool erased = false;
@@ -72,6 +112,14 @@ struct __template_info
 
 typedef map<string, vector<__multiTableSymbol>> multiSymbolTable;
 
+/*
+Function bodies are kept in an arena outside of the table, so
+that copying a symbol (as overload resolution does constantly)
+never copies its body. Bodies are never freed, so a symbol's
+pointer stays valid for the whole translation.
+*/
+sequence *newBody(const sequence &From = sequence());
+
 // typedef map<string, vector<__template_info>> multiTemplTable;
 
 extern multiSymbolTable table;
@@ -80,24 +128,38 @@ extern multiSymbolTable table;
 string toC(const sequence &What);
 
 // Converts lexed symbols into a type
-Type toType(const vector<string> &What);
+Type toType(const vector<token> &What);
 
 // Can throw errors (IE malformed definitions)
 // Takes in the whole definition, starting at let
 // and ending after }. (Oak has no trailing semicolon)
 // Can also handle templating
-void addStruct(const vector<string> &From);
+void addStruct(const vector<token> &From);
 
 // Extern defs
-string mangleStruct(const string &name, const vector<vector<string>> &generics);
-string instantiateGeneric(const string &what, const vector<vector<string>> &genericSubs, const vector<string> &typeVec);
+string mangleStruct(const string &name, const vector<vector<token>> &generics);
+string instantiateGeneric(const string &what, const vector<vector<token>> &genericSubs, const vector<token> &typeVec);
+
+/*
+Scopes. Rather than copying the whole table when a scope
+opens, the symbols a name held are saved the first time that
+name is given a new variable within the scope. Closing the
+scope only has to visit those names.
+*/
+
+// Opens a scope, returning what to pass to restoreSymbolTable
+size_t openScope();
+
+// Must be called before giving Name any symbol which is not a
+// function
+void saveSymbols(const string &Name);
 
 /*
-Erases any non-function symbols which were not present
-in the original table. However, skips all functions.
-If not contradicted by the above rules, bases off of
-the current table (not backup).
+Closes Scope (and any left open within it). Erases any
+non-function symbols which were not present when it opened.
+However, skips all functions. Returns the destructor calls
+for the variables falling out of scope.
 */
-string restoreSymbolTable(multiSymbolTable &backup);
+string restoreSymbolTable(const size_t &Scope);
 
 #endif
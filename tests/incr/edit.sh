@@ -0,0 +1,16 @@
+#!/bin/sh
+# Translates main.oak with -I, makes a one-line edit to it, and
+# checks that the second translation reloads std
+
+dir=$(mktemp -d)
+cp tests/incr/main.oak "$dir"
+cd "$dir" || exit 1
+
+acorn -I -t -o main.out main.oak > /dev/null || exit 1
+sed -i 's/Before/After/' main.oak
+acorn -I -d -t -o main.out main.oak | grep -q "Reloaded file '.*std.oak'"
+result=$?
+
+cd - > /dev/null
+rm -rf "$dir"
+exit $result
@@ -0,0 +1,133 @@
+/*
+Jordan Dehmel
+jdehmel@outlook.com
+github.com/jorbDehmel
+2023 - present
+GPLv3 held by author
+*/
+
+#include "token_buffer.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+tokenBuffer::tokenBuffer() : gapStart(0), gapEnd(0)
+{
+}
+
+tokenBuffer::tokenBuffer(const vector<token> &From) : data(From), gapStart(From.size()), gapEnd(From.size())
+{
+}
+
+tokenBuffer &tokenBuffer::operator=(const vector<token> &From)
+{
+    data = From;
+    gapStart = gapEnd = data.size();
+    return *this;
+}
+
+tokenBuffer &tokenBuffer::operator=(vector<token> &&From)
+{
+    data = std::move(From);
+    gapStart = gapEnd = data.size();
+    return *this;
+}
+
+void tokenBuffer::moveGap(const size_t &Pos)
+{
+    if (Pos > size())
+    {
+        throw runtime_error("Internal error; Token buffer position out of range.");
+    }
+
+    if (Pos < gapStart)
+    {
+        // Shift [Pos, gapStart) to the end of the gap
+        size_t toMove = gapStart - Pos;
+        copy_backward(data.begin() + Pos, data.begin() + gapStart, data.begin() + gapEnd);
+        gapStart -= toMove;
+        gapEnd -= toMove;
+    }
+    else if (Pos > gapStart)
+    {
+        // Shift the tokens after the gap up to its start
+        size_t toMove = Pos - gapStart;
+        copy(data.begin() + gapEnd, data.begin() + gapEnd + toMove, data.begin() + gapStart);
+        gapStart += toMove;
+        gapEnd += toMove;
+    }
+
+    return;
+}
+
+void tokenBuffer::reserveGap(const size_t &Count)
+{
+    if (gapEnd - gapStart >= Count)
+    {
+        return;
+    }
+
+    // Grow geometrically, keeping everything after the gap at the back
+    size_t tail = data.size() - gapEnd;
+    size_t newCapacity = max(data.size() * 2, size() + Count + 64);
+
+    data.resize(newCapacity);
+    copy_backward(data.begin() + gapEnd, data.begin() + gapEnd + tail, data.end());
+    gapEnd = newCapacity - tail;
+
+    return;
+}
+
+void tokenBuffer::erase(const size_t &Pos, const size_t &Count)
+{
+    if (Pos + Count > size())
+    {
+        throw runtime_error("Internal error; Cannot erase past the end of a token buffer.");
+    }
+
+    moveGap(Pos);
+    gapEnd += Count;
+
+    return;
+}
+
+void tokenBuffer::insert(const size_t &Pos, const token &What)
+{
+    moveGap(Pos);
+    reserveGap(1);
+    data[gapStart] = What;
+    gapStart++;
+
+    return;
+}
+
+void tokenBuffer::insert(const size_t &Pos, const vector<token> &What)
+{
+    moveGap(Pos);
+    reserveGap(What.size());
+    copy(What.begin(), What.end(), data.begin() + gapStart);
+    gapStart += What.size();
+
+    return;
+}
+
+void tokenBuffer::push_back(const token &What)
+{
+    insert(size(), What);
+    return;
+}
+
+void tokenBuffer::clear()
+{
+    data.clear();
+    gapStart = gapEnd = 0;
+    return;
+}
+
+vector<token> tokenBuffer::toVector() const
+{
+    vector<token> out;
+    out.reserve(size());
+    out.insert(out.end(), data.begin(), data.begin() + gapStart);
+    out.insert(out.end(), data.begin() + gapEnd, data.end());
+    return out;
+}
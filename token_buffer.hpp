@@ -0,0 +1,109 @@
+/*
+Jordan Dehmel
+jdehmel@outlook.com
+github.com/jorbDehmel
+2023 - present
+GPLv3 held by author
+
+A gap buffer of tokens. The consumptive passes of doFile,
+the rule engine and operator substitution all edit the token
+stream one token at a time near a moving cursor. With a plain
+vector every such edit shifts the entire tail of the file;
+Here the free space (the gap) is moved to the edit position
+instead, so a run of edits near the same spot costs only the
+distance the cursor has moved since the last one.
+*/
+
+#ifndef TOKEN_BUFFER_HPP
+#define TOKEN_BUFFER_HPP
+
+#include "tokens.hpp"
+#include <vector>
+
+using namespace std;
+
+class tokenBuffer
+{
+  public:
+    tokenBuffer();
+    tokenBuffer(const vector<token> &From);
+    tokenBuffer &operator=(const vector<token> &From);
+    tokenBuffer &operator=(vector<token> &&From);
+
+    size_t size() const
+    {
+        return data.size() - (gapEnd - gapStart);
+    }
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    // Index as if the gap was not there
+    token &operator[](const size_t &Index)
+    {
+        return Index < gapStart ? data[Index] : data[Index + (gapEnd - gapStart)];
+    }
+    const token &operator[](const size_t &Index) const
+    {
+        return Index < gapStart ? data[Index] : data[Index + (gapEnd - gapStart)];
+    }
+
+    // Edits; Positions are indices, not iterators
+    void erase(const size_t &Pos, const size_t &Count = 1);
+    void insert(const size_t &Pos, const token &What);
+    void insert(const size_t &Pos, const vector<token> &What);
+    void push_back(const token &What);
+    void clear();
+
+    // Flattened copy of the contents
+    vector<token> toVector() const;
+
+    // Read-only forward iteration
+    class const_iterator
+    {
+      public:
+        const_iterator(const tokenBuffer *Buffer, const size_t &Index) : buffer(Buffer), index(Index)
+        {
+        }
+
+        const token &operator*() const
+        {
+            return (*buffer)[index];
+        }
+        const_iterator &operator++()
+        {
+            index++;
+            return *this;
+        }
+        bool operator!=(const const_iterator &Other) const
+        {
+            return index != Other.index;
+        }
+
+      protected:
+        const tokenBuffer *buffer;
+        size_t index;
+    };
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+    const_iterator end() const
+    {
+        return const_iterator(this, size());
+    }
+
+  protected:
+    // Moves the gap so that it starts at Pos
+    void moveGap(const size_t &Pos);
+
+    // Ensures the gap can hold at least Count more tokens
+    void reserveGap(const size_t &Count);
+
+    vector<token> data;
+    size_t gapStart, gapEnd;
+};
+
+#endif
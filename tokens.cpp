@@ -0,0 +1,238 @@
+/*
+Jordan Dehmel
+jdehmel@outlook.com
+github.com/jorbDehmel
+2023 - present
+GPLv3 held by author
+*/
+
+#include "tokens.hpp"
+#include <cstring>
+
+// Must match the order of tok::fixedToken
+const static char *fixedTokenText[] = {
+    "",   ";",  ",",  "(",  ")",  "{",  "}",  "<",  ">",  ".",      ":",     "^",    "@",     "!",
+    "=",  "->", "*",  "/",  "%",  "+",  "-",  "<<", ">>", "&",      "|",     "<=",   ">=",    "==",
+    "!=", "&&", "||", "+=", "-=", "*=", "/=", "%=", "&=", "|=",     "let",   "struct", "enum", "if",
+    "while", "else", "return", "match", "case", "default", "pre", "post",
+
+    "include!", "link!", "package!", "flag!", "alloc!", "free!", "free_arr!", "erase!", "new_rule!", "use_rule!",
+    "rem_rule!", "bundle_rule!", "c_print!", "c_panic!", "c_sys!", "type!", "size!", "ptrcpy!", "ptrarr!", "raw_c!",
+};
+
+static_assert(sizeof(fixedTokenText) / sizeof(fixedTokenText[0]) == tok::fixed_token_count,
+              "fixedTokenText must have an entry for every tok::fixedToken");
+
+deque<string> *__tokenText = nullptr;
+static vector<tokenKind> *tokenKinds = nullptr;
+
+// Keys view into __tokenText, so no text is stored twice
+static unordered_map<string_view, unsigned int> *tokenIDs = nullptr;
+
+static unsigned int intern(const string_view &What);
+
+/*
+Makes the pool the first time it is needed, rather than as a
+static, so that tokens (and the types which hold them) can be
+made by static initializers in any file. The fixed tokens are
+interned first, so their IDs match their enum values. The pool
+is never freed, since tokens may outlive every other static.
+*/
+static inline void ensurePool()
+{
+    if (__tokenText != nullptr)
+    {
+        return;
+    }
+
+    __tokenText = new deque<string>;
+    tokenKinds = new vector<tokenKind>;
+    tokenIDs = new unordered_map<string_view, unsigned int>;
+
+    for (const char *text : fixedTokenText)
+    {
+        intern(text);
+    }
+
+    return;
+}
+
+// Returns the ID of the given text, interning it if needed
+static unsigned int intern(const string_view &What)
+{
+    ensurePool();
+
+    auto it = tokenIDs->find(What);
+    if (it != tokenIDs->end())
+    {
+        return it->second;
+    }
+
+    unsigned int id = __tokenText->size();
+    __tokenText->emplace_back(What);
+    tokenKinds->push_back(getTokenKind(What));
+    (*tokenIDs)[string_view(__tokenText->back())] = id;
+
+    return id;
+}
+
+tokenKind getTokenKind(const string_view &What)
+{
+    if (What.empty())
+    {
+        return operator_token;
+    }
+
+    char c = What[0];
+
+    if (('0' <= c && c <= '9') || c == '"' || c == '\'' ||
+        (c == '-' && What.size() > 1 && (('0' <= What[1] && What[1] <= '9') || What[1] == '.')))
+    {
+        return literal_token;
+    }
+    else if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_' || c == '$' || (unsigned char)c >= 128)
+    {
+        return identifier_token;
+    }
+
+    return operator_token;
+}
+
+token::token() : id(tok::none), line(0), kind(operator_token)
+{
+    ensurePool();
+}
+
+token::token(const string &What) : id(intern(What)), line(0), kind((*tokenKinds)[id])
+{
+}
+
+token::token(const string_view &What) : id(intern(What)), line(0), kind((*tokenKinds)[id])
+{
+}
+
+token::token(const char *What) : id(intern(What)), line(0), kind((*tokenKinds)[id])
+{
+}
+
+token::token(const tok::fixedToken &What) : id(What), line(0), kind(operator_token)
+{
+    ensurePool();
+    kind = (*tokenKinds)[id];
+}
+
+bool token::operator==(const string &Other) const
+{
+    return (*__tokenText)[id] == Other;
+}
+
+bool token::operator!=(const string &Other) const
+{
+    return (*__tokenText)[id] != Other;
+}
+
+bool token::operator==(const char *Other) const
+{
+    return strcmp((*__tokenText)[id].c_str(), Other) == 0;
+}
+
+bool token::operator!=(const char *Other) const
+{
+    return strcmp((*__tokenText)[id].c_str(), Other) != 0;
+}
+
+size_t token::size() const
+{
+    return (*__tokenText)[id].size();
+}
+
+bool token::empty() const
+{
+    return id == tok::none;
+}
+
+char token::front() const
+{
+    return (*__tokenText)[id].front();
+}
+
+char token::back() const
+{
+    return (*__tokenText)[id].back();
+}
+
+char token::operator[](const size_t &Index) const
+{
+    return (*__tokenText)[id][Index];
+}
+
+string token::substr(const size_t &Pos, const size_t &Len) const
+{
+    return (*__tokenText)[id].substr(Pos, Len);
+}
+
+const char *token::c_str() const
+{
+    return (*__tokenText)[id].c_str();
+}
+
+bool operator==(const string &Lhs, const token &Rhs)
+{
+    return Rhs == Lhs;
+}
+
+bool operator!=(const string &Lhs, const token &Rhs)
+{
+    return Rhs != Lhs;
+}
+
+bool operator==(const char *Lhs, const token &Rhs)
+{
+    return Rhs == Lhs;
+}
+
+bool operator!=(const char *Lhs, const token &Rhs)
+{
+    return Rhs != Lhs;
+}
+
+string operator+(const token &Lhs, const token &Rhs)
+{
+    return Lhs.str() + Rhs.str();
+}
+
+string operator+(const token &Lhs, const string &Rhs)
+{
+    return Lhs.str() + Rhs;
+}
+
+string operator+(const string &Lhs, const token &Rhs)
+{
+    return Lhs + Rhs.str();
+}
+
+string operator+(const token &Lhs, const char *Rhs)
+{
+    return Lhs.str() + Rhs;
+}
+
+string operator+(const char *Lhs, const token &Rhs)
+{
+    return Lhs + Rhs.str();
+}
+
+string operator+(const token &Lhs, const char &Rhs)
+{
+    return Lhs.str() + Rhs;
+}
+
+string operator+(const char &Lhs, const token &Rhs)
+{
+    return Lhs + Rhs.str();
+}
+
+ostream &operator<<(ostream &Stream, const token &What)
+{
+    Stream << What.str();
+    return Stream;
+}
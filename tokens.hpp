@@ -0,0 +1,205 @@
+/*
+Jordan Dehmel
+jdehmel@outlook.com
+github.com/jorbDehmel
+2023 - present
+GPLv3 held by author
+
+Interned tokens for the Oak front end. The text of every
+distinct token is stored exactly once in a global string
+pool, and a token is just an index into that pool plus a
+kind tag and the source line it came from. This makes tokens
+cheap to copy and makes comparing two tokens an integer
+comparison.
+*/
+
+#ifndef TOKENS_HPP
+#define TOKENS_HPP
+
+#include <deque>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// What a token is, as far as the lexer can tell
+enum tokenKind : unsigned char
+{
+    identifier_token, // Names, keywords, macros and rule variables
+    operator_token,   // Operators and other punctuation
+    literal_token,    // Numeric, string and character literals
+};
+
+/*
+Tokens which are interned before anything else. Since their
+IDs are known at compile time, comparing a token against one
+of these never touches the string pool. These must stay in
+the same order as fixedTokenText in tokens.cpp.
+*/
+namespace tok
+{
+enum fixedToken : unsigned int
+{
+    none = 0,   // ""
+    semicolon,  // ;
+    comma,      // ,
+    lparen,     // (
+    rparen,     // )
+    lbrace,     // {
+    rbrace,     // }
+    langle,     // <
+    rangle,     // >
+    dot,        // .
+    colon,      // :
+    caret,      // ^
+    at,         // @
+    bang,       // !
+    assign,     // =
+    arrow,      // ->
+    star,       // *
+    slash,      // /
+    percent,    // %
+    plus,       // +
+    minus,      // -
+    lshift,     // <<
+    rshift,     // >>
+    amp,        // &
+    pipe,       // |
+    less_eq,    // <=
+    greater_eq, // >=
+    equal,      // ==
+    not_equal,  // !=
+    amp_amp,    // &&
+    pipe_pipe,  // ||
+    plus_eq,    // +=
+    minus_eq,   // -=
+    star_eq,    // *=
+    slash_eq,   // /=
+    percent_eq, // %=
+    amp_eq,     // &=
+    pipe_eq,    // |=
+    let_kw,     // let
+    struct_kw,  // struct
+    enum_kw,    // enum
+    if_kw,      // if
+    while_kw,   // while
+    else_kw,    // else
+    return_kw,  // return
+    match_kw,   // match
+    case_kw,    // case
+    default_kw, // default
+    pre_kw,     // pre
+    post_kw,    // post
+
+    // Macros which the translator handles itself
+    include_macro,     // include!
+    link_macro,        // link!
+    package_macro,     // package!
+    flag_macro,        // flag!
+    alloc_macro,       // alloc!
+    free_macro,        // free!
+    free_arr_macro,    // free_arr!
+    erase_macro,       // erase!
+    new_rule_macro,    // new_rule!
+    use_rule_macro,    // use_rule!
+    rem_rule_macro,    // rem_rule!
+    bundle_rule_macro, // bundle_rule!
+    c_print_macro,     // c_print!
+    c_panic_macro,     // c_panic!
+    c_sys_macro,       // c_sys!
+    type_macro,        // type!
+    size_macro,        // size!
+    ptrcpy_macro,      // ptrcpy!
+    ptrarr_macro,      // ptrarr!
+    raw_c_macro,       // raw_c!
+
+    fixed_token_count
+};
+} // namespace tok
+
+// For internal use: The text of every interned token, by ID.
+// A deque, so that references into it are never invalidated.
+// Made when the first token is.
+extern deque<string> *__tokenText;
+
+class token
+{
+  public:
+    token();
+    token(const string &What);
+    token(const string_view &What);
+    token(const char *What);
+    token(const tok::fixedToken &What);
+
+    // The pooled text of this token
+    const string &str() const
+    {
+        return (*__tokenText)[id];
+    }
+    operator const string &() const
+    {
+        return (*__tokenText)[id];
+    }
+
+    // Integer comparisons; The source line is not compared
+    bool operator==(const token &Other) const
+    {
+        return id == Other.id;
+    }
+    bool operator!=(const token &Other) const
+    {
+        return id != Other.id;
+    }
+    bool operator==(const tok::fixedToken &Other) const
+    {
+        return id == Other;
+    }
+    bool operator!=(const tok::fixedToken &Other) const
+    {
+        return id != Other;
+    }
+
+    // Text comparisons; These do not intern their argument
+    bool operator==(const string &Other) const;
+    bool operator!=(const string &Other) const;
+    bool operator==(const char *Other) const;
+    bool operator!=(const char *Other) const;
+
+    // Read-only string accessors
+    size_t size() const;
+    bool empty() const;
+    char front() const;
+    char back() const;
+    char operator[](const size_t &Index) const;
+    string substr(const size_t &Pos, const size_t &Len = string::npos) const;
+    const char *c_str() const;
+
+    unsigned int id;
+    unsigned int line; // 0 if unknown
+    tokenKind kind;
+};
+
+// Text comparisons with the token on the right
+bool operator==(const string &Lhs, const token &Rhs);
+bool operator!=(const string &Lhs, const token &Rhs);
+bool operator==(const char *Lhs, const token &Rhs);
+bool operator!=(const char *Lhs, const token &Rhs);
+
+// Concatenation always yields a plain string
+string operator+(const token &Lhs, const token &Rhs);
+string operator+(const token &Lhs, const string &Rhs);
+string operator+(const string &Lhs, const token &Rhs);
+string operator+(const token &Lhs, const char *Rhs);
+string operator+(const char *Lhs, const token &Rhs);
+string operator+(const token &Lhs, const char &Rhs);
+string operator+(const char &Lhs, const token &Rhs);
+
+ostream &operator<<(ostream &Stream, const token &What);
+
+// Classifies some token text
+tokenKind getTokenKind(const string_view &What);
+
+#endif
@@ -1,6 +1,8 @@
 #include "type_builder.hpp"
 #include "sequence.hpp"
 #include "sequence_resources.hpp"
+#include <deque>
+#include <unordered_set>
 
 set<string> deps;
 map<string, __structLookupData> structData;
@@ -31,28 +33,105 @@ bool typeNode::operator==(const typeNode &other) const
     }
 }
 
+struct __typeNodesHash
+{
+    size_t operator()(const typeNodes *What) const
+    {
+        size_t out = What->nodes.size();
+        for (const auto &node : What->nodes)
+        {
+            out = out * 1000003 ^ (((size_t)node.info << 32) | node.name.id);
+        }
+        return out;
+    }
+};
+
+// Exact: Unlike typeNode::operator==, names always count
+struct __typeNodesEqual
+{
+    bool operator()(const typeNodes *A, const typeNodes *B) const
+    {
+        if (A->nodes.size() != B->nodes.size())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < A->nodes.size(); i++)
+        {
+            if (A->nodes[i].info != B->nodes[i].info || A->nodes[i].name != B->nodes[i].name)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+// Returns the one copy of Nodes. Function statics, since
+// nullType is made during static initialisation.
+static const typeNodes *internNodes(vector<typeNode> &&Nodes)
+{
+    static unordered_set<const typeNodes *, __typeNodesHash, __typeNodesEqual> interned;
+    static deque<typeNodes> pool; // Never invalidates pointers
+    static const token noName = token("");
+
+    typeNodes candidate;
+    candidate.nodes = std::move(Nodes);
+
+    auto found = interned.find(&candidate);
+    if (found != interned.end())
+    {
+        return *found;
+    }
+
+    pool.push_back(std::move(candidate));
+    typeNodes &out = pool.back();
+    interned.insert(&out);
+
+    vector<typeNode> shape = out.nodes;
+    bool isShape = true;
+    for (auto &node : shape)
+    {
+        if (node.info == pointer)
+        {
+            out.pointers++;
+        }
+
+        if (node.info != atomic && node.name != noName)
+        {
+            node.name = noName;
+            isShape = false;
+        }
+    }
+
+    out.shape = isShape ? &out : internNodes(std::move(shape));
+    return &out;
+}
+
+static const typeNodes *getNullNodes()
+{
+    static const typeNodes *out = internNodes({{atomic, "NULL"}});
+    return out;
+}
+
 const Type nullType(atomic, "NULL");
 
 Type::Type(const TypeInfo &Info, const string &Name)
 {
-    internal.clear();
-    internal.push_back({Info, Name});
+    data = internNodes({{Info, Name}});
     ID = currentID++;
     return;
 }
 
 const size_t Type::size() const
 {
-    return internal.size();
+    return data->nodes.size();
 }
 
 Type::Type(const Type &What)
 {
-    internal.clear();
-    for (const auto &i : What.internal)
-    {
-        internal.push_back(i);
-    }
+    data = What.data;
     ID = currentID++;
 
     return;
@@ -60,41 +139,55 @@ Type::Type(const Type &What)
 
 Type::Type(const Type &What, const int &startingAt)
 {
-    internal.clear();
-    for (int i = startingAt; i < What.size(); i++)
+    vector<typeNode> nodes;
+    for (size_t i = startingAt; i < What.size(); i++)
     {
-        internal.push_back(What.internal[i]);
+        nodes.push_back(What.data->nodes[i]);
     }
+
+    data = internNodes(std::move(nodes));
     ID = currentID++;
 
     return;
 }
 
+Type::Type(const vector<typeNode> &Nodes)
+{
+    data = internNodes(vector<typeNode>(Nodes));
+    ID = currentID++;
+    return;
+}
+
 Type::Type()
 {
-    internal.clear();
-    internal.push_back(typeNode{nullType.internal[0].info, nullType.internal[0].name});
+    data = getNullNodes();
     ID = currentID++;
     return;
 }
 
 void Type::prepend(const TypeInfo &Info, const string &Name)
 {
-    internal.insert(internal.begin(), {Info, Name});
+    vector<typeNode> nodes;
+    nodes.reserve(data->nodes.size() + 1);
+    nodes.push_back({Info, Name});
+    nodes.insert(nodes.end(), data->nodes.begin(), data->nodes.end());
+
+    data = internNodes(std::move(nodes));
     ID = currentID++;
     return;
 }
 
 void Type::append(const TypeInfo &Info, const string &Name)
 {
-    if (internal.size() == 1 && internal[0].info == atomic && internal[0].name == "NULL")
+    if (data == getNullNodes())
     {
-        internal[0].info = Info;
-        internal[0].name = Name;
+        data = internNodes({{Info, Name}});
     }
     else
     {
-        internal.push_back({Info, Name});
+        vector<typeNode> nodes = data->nodes;
+        nodes.push_back({Info, Name});
+        data = internNodes(std::move(nodes));
     }
     ID = currentID++;
 
@@ -103,30 +196,34 @@ void Type::append(const TypeInfo &Info, const string &Name)
 
 void Type::append(const Type &Other)
 {
-    if (internal.size() == 1 && internal[0].info == atomic && internal[0].name == "NULL")
+    if (data == getNullNodes())
     {
-        internal[0] = Other.internal[0];
+        data = internNodes({Other.data->nodes[0]});
     }
     else
     {
-        for (const auto &i : Other.internal)
-        {
-            internal.push_back(i);
-        }
+        vector<typeNode> nodes = data->nodes;
+        nodes.insert(nodes.end(), Other.data->nodes.begin(), Other.data->nodes.end());
+        data = internNodes(std::move(nodes));
     }
     ID = currentID++;
 
     return;
 }
 
-void Type::reserve(const unsigned long long &To)
+void Type::set(const int &Index, const typeNode &What)
 {
-    internal.reserve(To);
+    vector<typeNode> nodes = data->nodes;
+    nodes[Index] = What;
+
+    data = internNodes(std::move(nodes));
+    ID = currentID++;
+    return;
 }
 
 bool Type::operator==(const Type &Other) const
 {
-    return internal == Other.internal;
+    return data->shape == Other.data->shape;
 }
 
 bool Type::operator!=(const Type &Other) const
@@ -136,39 +233,34 @@ bool Type::operator!=(const Type &Other) const
 
 Type &Type::operator=(const Type &Other)
 {
-    internal.clear();
-    for (const auto &i : Other.internal)
-    {
-        internal.push_back(i);
-    }
+    data = Other.data;
     ID = currentID++;
     return *this;
 }
 
 Type &Type::operator=(const typeNode &Other)
 {
-    internal.clear();
-    internal.push_back(Other);
+    data = internNodes({Other});
     ID = currentID++;
     return *this;
 }
 
 string toStr(const Type *const What, const unsigned int &pos)
 {
-    if (What == nullptr || pos >= What->internal.size())
+    if (What == nullptr || pos >= What->nodes().size())
     {
         return "";
     }
 
     string out = "";
 
-    switch (What->internal[pos].info)
+    switch (What->nodes()[pos].info)
     {
     case arr:
         out += "[]";
         break;
     case sarr:
-        out += "[" + What->internal[pos].name + "]";
+        out += "[" + What->nodes()[pos].name + "]";
         break;
     case pointer:
         out += "^";
@@ -183,42 +275,46 @@ string toStr(const Type *const What, const unsigned int &pos)
         out += "(";
         break;
     case var_name:
-        out += What->internal[pos].name + ":";
+        out += What->nodes()[pos].name + ":";
         break;
     default:
-        out += What->internal[pos].name;
+        out += What->nodes()[pos].name;
         break;
     }
 
-    if (pos < What->internal.size())
+    if (pos + 1 < What->nodes().size())
     {
-        if (What->internal[pos + 1].info != function && What->internal[pos + 1].info != pointer &&
-            What->internal[pos + 1].info != join && What->internal[pos + 1].info != maps &&
-            What->internal[pos].info != pointer && What->internal[pos].info != function)
+        if (What->nodes()[pos + 1].info != function && What->nodes()[pos + 1].info != pointer &&
+            What->nodes()[pos + 1].info != join && What->nodes()[pos + 1].info != maps &&
+            What->nodes()[pos].info != pointer && What->nodes()[pos].info != function)
         {
             out += " ";
         }
-        else if (What->internal[pos].info == var_name)
+        else if (What->nodes()[pos].info == var_name)
         {
             out += " ";
         }
 
         out += toStr(What, pos + 1);
     }
+    else if (What->nodes()[pos].info == var_name)
+    {
+        out += " ";
+    }
 
     return out;
 }
 
 void Type::pop_front()
 {
-    internal.erase(internal.begin());
+    data = internNodes(vector<typeNode>(data->nodes.begin() + 1, data->nodes.end()));
     ID = currentID++;
     return;
 }
 
 void Type::pop_back()
 {
-    internal.pop_back();
+    data = internNodes(vector<typeNode>(data->nodes.begin(), data->nodes.end() - 1));
     ID = currentID++;
     return;
 }
@@ -228,14 +324,21 @@ void Type::pop_back()
 // of arguments
 bool typesAreSame(const Type *const A, const Type *const B, int &changes)
 {
+    // The walk below counts every pointer on both sides
+    if (A->interned() == B->interned())
+    {
+        changes += 2 * A->interned()->pointers;
+        return true;
+    }
+
     unsigned int left, right;
     left = right = 0;
 
-    while (left < A->internal.size() && right < B->internal.size())
+    while (left < A->nodes().size() && right < B->nodes().size())
     {
-        while (left < A->internal.size() && (A->internal[left].info == var_name || A->internal[left].info == pointer))
+        while (left < A->nodes().size() && (A->nodes()[left].info == var_name || A->nodes()[left].info == pointer))
         {
-            if (A->internal[left].info == pointer)
+            if (A->nodes()[left].info == pointer)
             {
                 changes++;
             }
@@ -243,10 +346,10 @@ bool typesAreSame(const Type *const A, const Type *const B, int &changes)
             left++;
         }
 
-        while (right < B->internal.size() &&
-               (B->internal[right].info == var_name || B->internal[right].info == pointer))
+        while (right < B->nodes().size() &&
+               (B->nodes()[right].info == var_name || B->nodes()[right].info == pointer))
         {
-            if (B->internal[right].info == pointer)
+            if (B->nodes()[right].info == pointer)
             {
                 changes++;
             }
@@ -254,21 +357,21 @@ bool typesAreSame(const Type *const A, const Type *const B, int &changes)
             right++;
         }
 
-        if (left >= A->internal.size() || right >= B->internal.size())
+        if (left >= A->nodes().size() || right >= B->nodes().size())
         {
             break;
         }
 
-        if (A->internal[left].info != B->internal[right].info &&
-            !(A->internal[left].info == sarr && B->internal[right].info == arr) &&
-            !(A->internal[left].info == arr && B->internal[right].info == sarr))
+        if (A->nodes()[left].info != B->nodes()[right].info &&
+            !(A->nodes()[left].info == sarr && B->nodes()[right].info == arr) &&
+            !(A->nodes()[left].info == arr && B->nodes()[right].info == sarr))
         {
             // Failure
             return false;
         }
         else
         {
-            if (A->internal[left].info == atomic && A->internal[left].name != B->internal[right].name)
+            if (A->nodes()[left].info == atomic && A->nodes()[left].name != B->nodes()[right].name)
             {
                 // Failure
                 return false;
@@ -286,36 +389,41 @@ bool typesAreSame(const Type *const A, const Type *const B, int &changes)
 // Like the above, but does not do auto-referencing or dereferencing
 bool typesAreSameExact(const Type *const A, const Type *const B)
 {
+    if (A->interned() == B->interned())
+    {
+        return true;
+    }
+
     unsigned int left, right;
     left = right = 0;
 
-    while (left < A->internal.size() && right < B->internal.size())
+    while (left < A->nodes().size() && right < B->nodes().size())
     {
-        while (left < A->internal.size() && A->internal[left].info == var_name)
+        while (left < A->nodes().size() && A->nodes()[left].info == var_name)
         {
             left++;
         }
 
-        while (right < B->internal.size() && B->internal[right].info == var_name)
+        while (right < B->nodes().size() && B->nodes()[right].info == var_name)
         {
             right++;
         }
 
-        if (left >= A->internal.size() || right >= B->internal.size())
+        if (left >= A->nodes().size() || right >= B->nodes().size())
         {
             break;
         }
 
-        if (A->internal[left].info != B->internal[right].info &&
-            !(A->internal[left].info == sarr && B->internal[right].info == arr) &&
-            !(A->internal[left].info == arr && B->internal[right].info == sarr))
+        if (A->nodes()[left].info != B->nodes()[right].info &&
+            !(A->nodes()[left].info == sarr && B->nodes()[right].info == arr) &&
+            !(A->nodes()[left].info == arr && B->nodes()[right].info == sarr))
         {
             // Failure
             return false;
         }
         else
         {
-            if (A->internal[left].info == atomic && A->internal[left].name != B->internal[right].name)
+            if (A->nodes()[left].info == atomic && A->nodes()[left].name != B->nodes()[right].name)
             {
                 // Failure
                 return false;
@@ -493,7 +601,7 @@ Type checkLiteral(const string &From)
     return nullType;
 }
 
-typeNode &Type::operator[](const int &Index) const
+const typeNode &Type::operator[](const int &Index) const
 {
-    return (typeNode &)internal[Index];
+    return data->nodes[Index];
 }
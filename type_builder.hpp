@@ -14,6 +14,9 @@ Underlying class for representing types in Oak source code.
 #include <set>
 #include <string>
 #include <vector>
+
+#include "tokens.hpp"
+
 using namespace std;
 
 #define DB_INFO __FILE__ << ':' << __LINE__ << ' '
@@ -36,7 +39,25 @@ struct typeNode
     bool operator==(const typeNode &other) const;
 
     TypeInfo info;
-    string name;
+
+    // Interned like any token, so that nodes are cheap to copy and
+    // compare
+    token name;
+};
+
+// The nodes of a Type. Each distinct list of nodes is kept only
+// once and never changes, so Types share them: Copying a Type
+// copies a pointer, and equal Types have equal pointers.
+struct typeNodes
+{
+    vector<typeNode> nodes;
+
+    // The same list with the names of all non-atomic nodes left
+    // out, which is what typeNode::operator== compares
+    const typeNodes *shape = nullptr;
+
+    // How many of the nodes are pointers
+    unsigned int pointers = 0;
 };
 
 class Type
@@ -45,6 +66,7 @@ class Type
     Type(const TypeInfo &Info, const string &Name = "");
     Type(const Type &What);
     Type(const Type &What, const int &startingAt);
+    Type(const vector<typeNode> &Nodes);
     Type();
 
     void prepend(const TypeInfo &Info, const string &Name = "");
@@ -54,6 +76,9 @@ class Type
     void pop_front();
     void pop_back();
 
+    // Replaces the node at Index
+    void set(const int &Index, const typeNode &What);
+
     Type &operator=(const Type &Other);
     Type &operator=(const typeNode &Other);
 
@@ -62,14 +87,23 @@ class Type
 
     const size_t size() const;
 
-    // Not const, but does not modify ID
-    void reserve(const unsigned long long &To);
+    const typeNode &operator[](const int &Index) const;
 
-    typeNode &operator[](const int &Index) const;
+    const vector<typeNode> &nodes() const
+    {
+        return data->nodes;
+    }
+    const typeNodes *interned() const
+    {
+        return data;
+    }
 
+    // Unique to this object and its current nodes; Changes
+    // whenever they do
     unsigned long long ID;
 
-    vector<typeNode> internal;
+  protected:
+    const typeNodes *data;
 };
 
 ////////////////////////////////////////////////////////////////